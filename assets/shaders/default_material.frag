@@ -13,6 +13,8 @@ For more information see the LICENSE file
 
 #version 150
 
+#pragma include <uniform_blocks.glsl>
+
 #define PI 3.14159265359
 #define PI2 6.28318530718
 #define RECIPROCAL_PI2 0.15915494
@@ -43,38 +45,12 @@ in vec3 v_normal;
 in vec3 v_worldPos;
 in mat3 v_tanToWorld;
 
-const int MAX_LIGHTS = 8;
 const int TYPE_POINT = 0;
 const int TYPE_DIRECTIONAL = 1;
 const int TYPE_SPOT = 2;
 
-//const int SHADOW_NONE = 0;
-//const int SHADOW_HARD = 1;
-//const int SHADOW_SOFT = 2;
-//const int SHADOW_SOFTER = 3;
-
-//in vec4 FragPosLightSpace;
-//uniform sampler2D u_shadowMap;
-//uniform bool u_shadowEnabled;
-struct Light {
-    int type;
-    vec3 position;
-    vec3 ambient;
-    vec4 color;
-    float distance;
-    float intensity;
-    vec3 direction;
-    float cutOffAngle;
-    float cutOffSoftness;
-
-	vec4 shadowColor;
-	float shadowAlpha;
-
-    sampler2D shadowMap;
-    bool shadowEnabled;
-    int shadowType;
-    mat4 shadowMatrix;
-};
+// samplers cant live in a uniform block, they're indexed the same as u_lights
+uniform sampler2D u_shadowMaps[MAX_LIGHTS];
 
 float SampleShadowMap(in sampler2D shadowMap, vec2 coords, float compare) {
     if (coords.x < 0.0 || coords.x > 1.0 || coords.y < 0.0 || coords.y > 1.0)
@@ -140,55 +116,45 @@ float CalcShadowMap(in sampler2D shadowMap, vec4 fragPosLightSpace) {
     return SampleShadowMapPCF(shadowMap, projCoords.xy, projCoords.z, texelSize);
 }
 
-float calcVerySoftShadowMap(in Light light, in vec4 lightSpacePos)
+float calcVerySoftShadowMap(in sampler2D shadowMap, in vec4 lightSpacePos)
 {
-    return CalcShadowMap(light.shadowMap, lightSpacePos);
+    return CalcShadowMap(shadowMap, lightSpacePos);
 }
 
-float calcSoftShadowMap(in Light light, in vec4 fragPosLightSpace)
+float calcSoftShadowMap(in sampler2D shadowMap, in vec4 fragPosLightSpace)
 {
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
     projCoords = projCoords * 0.5 + 0.5;
-    vec2 texelSize = 1.0 / textureSize(light.shadowMap, 0);
-    return SampleShadowMapPCF3x3(light.shadowMap, projCoords.xy, projCoords.z, texelSize);
+    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    return SampleShadowMapPCF3x3(shadowMap, projCoords.xy, projCoords.z, texelSize);
 }
 
-float calcHardShadowMap(in Light light, in vec4 lightSpacePos)
+float calcHardShadowMap(in sampler2D shadowMap, in vec4 lightSpacePos)
 {
     vec3 projCoords = lightSpacePos.xyz / lightSpacePos.w;
     projCoords = projCoords * 0.5 + 0.5;
-    //return SampleShadowMap(light.shadowMap,projCoords.xy,projCoords.z);
+    //return SampleShadowMap(shadowMap,projCoords.xy,projCoords.z);
     if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0)
         return 1.0;
-    if (projCoords.z > texture(light.shadowMap, projCoords.xy).r)
+    if (projCoords.z > texture(shadowMap, projCoords.xy).r)
         return 0.0;
     return 1.0;
 }
 
 
 //  Handles shadowing for lights with different shadowing types
-float calculateShadowFactor(in Light light, in vec3 worldPos)
+float calculateShadowFactor(in LightData light, in sampler2D shadowMap, in vec3 worldPos)
 {
     vec4 lightSpacePos = light.shadowMatrix * vec4(v_worldPos, 1.0);
     if (light.shadowType==SHADOW_HARD)
-        return calcHardShadowMap(light, lightSpacePos);
+        return calcHardShadowMap(shadowMap, lightSpacePos);
     if (light.shadowType==SHADOW_SOFT)
-        return calcSoftShadowMap(light, lightSpacePos);
+        return calcSoftShadowMap(shadowMap, lightSpacePos);
 	if (light.shadowType==SHADOW_VERYSOFT)
-        return calcVerySoftShadowMap(light, lightSpacePos);
+        return calcVerySoftShadowMap(shadowMap, lightSpacePos);
     return 1.0f;
 }
 
-
-
-uniform sampler2D shadowMaps[MAX_LIGHTS];
-
-uniform Light u_lights[MAX_LIGHTS];
-uniform int u_lightCount;
-
-uniform vec3 u_eyePos;
-uniform vec3 u_sceneAmbient; 
-
 struct Material
 {
     vec3 diffuse;
@@ -201,15 +167,7 @@ struct Material
 
 uniform Material u_material;
 
-struct Fog
-{
-    bool enabled;
-    float start;
-    float end;
-    vec4 color;
-};
-
-uniform Fog u_fogData;
+uniform bool u_fogEnabled;
 
 out vec4 fragColor;
 
@@ -301,7 +259,7 @@ void main()
 
         //vec4 FragPosLightSpace = u_lights[i].shadowMatrix * vec4(v_worldPos, 1.0);
         //float shadowFactor = u_lights[i].shadowEnabled ? CalcShadowMap(u_lights[i].shadowMap,FragPosLightSpace) : 1.0;
-        float shadowFactor = calculateShadowFactor(u_lights[i], v_worldPos);
+        float shadowFactor = calculateShadowFactor(u_lights[i], u_shadowMaps[i], v_worldPos);
 
 		float shadow = mix(1.0, shadowFactor, u_lights[i].shadowAlpha);
         diffuse += mix(u_lights[i].shadowColor.rgb, atten*ndl*u_lights[i].intensity*u_lights[i].color.rgb, shadow);
@@ -339,11 +297,11 @@ void main()
         finalColor = mix(finalColor,reflCol,u_reflectionInfluence);
     }
 
-    if(u_fogData.enabled)
+    if(u_fogEnabled)
     {
         float zDist = length(v_worldPos-u_eyePos);
-        float fogFactor = clamp((zDist-u_fogData.start)/(u_fogData.end-u_fogData.start),0,1);
-        finalColor = mix(finalColor,u_fogData.color.rgb,fogFactor);
+        float fogFactor = clamp((zDist-u_fogStart)/(u_fogEnd-u_fogStart),0,1);
+        finalColor = mix(finalColor,u_fogColor.rgb,fogFactor);
     }
 
     fragColor = vec4(finalColor, 0.65);
@@ -11,11 +11,17 @@ For more information see the LICENSE file
 
 #version 150
 
+#pragma include <uniform_blocks.glsl>
+
 in vec3 a_pos;
 in vec2 a_texCoord;
 in vec3 a_normal;
 in vec3 a_tangent;
 
+#ifdef INSTANCING_ENABLED
+in mat4 a_instanceWorldMatrix;
+#endif
+
 #ifdef SKINNING_ENABLED
 const int MAX_BONES = 100;
 uniform mat4 u_bones[MAX_BONES];
@@ -24,8 +30,6 @@ in vec4 a_boneIndices;
 #endif
 
 uniform mat4 matrix;
-uniform mat4 u_viewMatrix;
-uniform mat4 u_projMatrix;
 uniform mat4 u_worldMatrix;
 uniform mat3 u_normalMatrix;
 uniform float u_textureScale;
@@ -62,13 +66,22 @@ void main()
 
 #else
 
-    v_worldPos = (u_worldMatrix*vec4(a_pos,1.0)).xyz;
-    gl_Position = u_projMatrix*u_viewMatrix*u_worldMatrix*vec4(a_pos,1.0);
+#ifdef INSTANCING_ENABLED
+    // there are no attribute locations left for a normal matrix so it's derived here
+    mat4 worldMatrix = a_instanceWorldMatrix;
+    mat3 normalMatrix = transpose(inverse(mat3(a_instanceWorldMatrix)));
+#else
+    mat4 worldMatrix = u_worldMatrix;
+    mat3 normalMatrix = u_normalMatrix;
+#endif
+
+    v_worldPos = (worldMatrix*vec4(a_pos,1.0)).xyz;
+    gl_Position = u_projMatrix*u_viewMatrix*worldMatrix*vec4(a_pos,1.0);
 
     v_texCoord = a_texCoord*u_textureScale;
 
-    v_normal = normalize((u_normalMatrix*a_normal));
-    vec3 v_tangent = normalize((u_normalMatrix*a_tangent));
+    v_normal = normalize((normalMatrix*a_normal));
+    vec3 v_tangent = normalize((normalMatrix*a_tangent));
     vec3 v_bitangent = cross(v_tangent,v_normal);
 
     v_tanToWorld = mat3(v_tangent,v_bitangent,v_normal);
@@ -14,12 +14,24 @@ For more information see the LICENSE file
 in vec3 a_pos;
 in vec2 a_texCoord;
 
+// per particle, xyz is the position and w the scale
+in vec4 a_particle;
+// x is the rotation in degrees and y the age from 0 to 1
+in vec4 a_particleParams;
+
 out vec2 o_texCoord;
 
 uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
+uniform mat4 viewMatrix;
 
 void main() {
-    gl_Position = projectionMatrix * modelViewMatrix * vec4(a_pos, 1.0);
+    // the quad faces the camera so it's built in view space around the particle
+    float angle = radians(a_particleParams.x);
+    float c = cos(angle);
+    float s = sin(angle);
+    vec2 corner = mat2(c, s, -s, c) * (a_pos.xy * a_particle.w);
+
+    vec4 viewPos = viewMatrix * vec4(a_particle.xyz, 1.0);
+    gl_Position = projectionMatrix * (viewPos + vec4(corner, 0.0, 0.0));
     o_texCoord = a_texCoord;
 }
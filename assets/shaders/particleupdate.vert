@@ -0,0 +1,137 @@
+/**************************************************************************
+This file is part of JahshakaVR, VR Authoring Toolkit
+http://www.jahshaka.com
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#version 150 core
+
+// state of the particle in this instance's slot
+// xyz is the position and w the scale
+in vec4 a_particle;
+// x is the rotation in degrees, y the age from 0 to 1, z the elapsed time and w the life length
+in vec4 a_particleParams;
+// xyz is the velocity and w the gravity effect
+in vec4 a_particleVelocity;
+
+// captured into the next state buffer in the same layout
+out vec4 o_particle;
+out vec4 o_particleParams;
+out vec4 o_particleVelocity;
+
+uniform float delta;
+// every slot starts free, the inputs are ignored
+uniform int clear;
+
+uniform int capacity;
+// slots emitSlot to emitSlot + emitCount, wrapping around, get new particles if they're free
+uniform int emitSlot;
+uniform int emitCount;
+// particles emitted before this update
+uniform uint emitIndex;
+uniform uint seed;
+
+uniform vec3 emitterPosition;
+uniform vec3 emitDirection;
+uniform vec3 boundDimension;
+uniform float speed;
+uniform float speedError;
+uniform float particleScale;
+uniform float scaleError;
+uniform float lifeLength;
+uniform float lifeError;
+uniform float gravity;
+uniform int randomRotation;
+uniform int dissipate;
+uniform int dissipateInv;
+
+// same as PARTICLE_GRAVITY
+const float PARTICLE_GRAVITY = -50.0;
+const float PI = 3.14159265358979323846;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// n-th random value of a particle, uniform in [0, 1)
+float random(uint particle, uint n) {
+    return float(hash(seed ^ hash(particle * 8u + n)) >> 8) * (1.0 / 16777216.0);
+}
+
+float generateValue(float average, float errorMargin, float r) {
+    return average + (r - 0.5) * 2.0 * errorMargin;
+}
+
+void main() {
+    vec3 position = a_particle.xyz;
+    float scale = a_particle.w;
+    float rotation = a_particleParams.x;
+    float elapsed = a_particleParams.z;
+    float life = a_particleParams.w;
+    vec3 velocity = a_particleVelocity.xyz;
+    float gravityEffect = a_particleVelocity.w;
+
+    bool alive = clear == 0 && life > 0.0 && elapsed <= life;
+
+    // a slot that's still alive keeps its particle so emitting stops while every slot is used
+    int emitOffset = (gl_InstanceID - emitSlot + capacity) % capacity;
+    if (!alive && emitOffset < emitCount) {
+        uint particle = emitIndex + uint(emitOffset);
+
+        // same values as ParticleSystemNode::emitParticle
+        velocity = emitDirection * generateValue(speed, speedError, random(particle, 0u));
+        scale = generateValue(particleScale, scaleError, random(particle, 1u));
+        life = generateValue(lifeLength, lifeError, random(particle, 2u));
+
+        float theta = random(particle, 3u) * 2.0 * PI;
+        float z = random(particle, 4u) * 2.0 - 1.0;
+        float rootOneMinusZSquared = sqrt(1.0 - z * z);
+        vec3 unitVector = vec3(rootOneMinusZSquared * cos(theta), rootOneMinusZSquared * sin(theta), z);
+        position = emitterPosition + boundDimension * unitVector;
+
+        rotation = randomRotation != 0 ? random(particle, 5u) * 360.0 : 0.0;
+        gravityEffect = gravity;
+        elapsed = 0.0;
+        alive = true;
+    }
+
+    // same as ParticlePool::integrate
+    if (alive) {
+        velocity.y += PARTICLE_GRAVITY * gravityEffect * delta;
+        position += velocity * delta;
+        elapsed += delta;
+
+        if (dissipate != 0 && elapsed > 0.0) {
+            float t = elapsed / life;
+            if (dissipateInv != 0)
+                scale = mix(0.0, particleScale, t);
+            else
+                scale *= 1.0 - t;
+        }
+
+        alive = life > 0.0 && elapsed <= life;
+    }
+
+    // free slots are still drawn so they're given no size
+    if (!alive) {
+        scale = 0.0;
+        elapsed = life + 1.0;
+    }
+
+    o_particle = vec4(position, scale);
+    o_particleParams = vec4(rotation, life > 0.0 ? elapsed / life : 1.0, elapsed, life);
+    o_particleVelocity = vec4(velocity, gravityEffect);
+
+    // nothing is rasterized while updating
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,41 @@
+// Per-frame data uploaded once by the renderer
+// layouts must match src/graphics/uniformblocks.h
+
+layout(std140) uniform CameraData
+{
+    mat4 u_viewMatrix;
+    mat4 u_projMatrix;
+    vec3 u_eyePos;
+    float u_time;
+    vec3 u_sceneAmbient;
+};
+
+layout(std140) uniform FogData
+{
+    vec4 u_fogColor;
+    float u_fogStart;
+    float u_fogEnd;
+};
+
+const int MAX_LIGHTS = 8;
+
+struct LightData {
+    vec4 color;
+    vec4 shadowColor;
+    vec3 position;
+    int type;
+    vec3 direction;
+    float distance;
+    float intensity;
+    float cutOffAngle;
+    float cutOffSoftness;
+    float shadowAlpha;
+    mat4 shadowMatrix;
+    int shadowType;
+};
+
+layout(std140) uniform LightsData
+{
+    LightData u_lights[MAX_LIGHTS];
+    int u_lightCount;
+};
@@ -0,0 +1,89 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Times submitting items to a RenderList and sorting them, the way the
+// scene fills its lists every frame
+// usage: renderlistbenchmark [items] [frames]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QMatrix4x4>
+#include <cstdio>
+
+#include "graphics/renderlist.h"
+#include "graphics/renderitem.h"
+#include "graphics/mesh.h"
+#include "materials/defaultmaterial.h"
+
+using namespace iris;
+
+#define MESH_COUNT 64
+#define MATERIAL_COUNT 16
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    auto args = app.arguments();
+    int itemCount = args.size() > 1 ? args[1].toInt() : 100000;
+    int frameCount = args.size() > 2 ? args[2].toInt() : 100;
+
+    QVector<MeshPtr> meshes;
+    for (int i = 0; i < MESH_COUNT; i++)
+        meshes.append(Mesh::create());
+
+    QVector<MaterialPtr> materials;
+    for (int i = 0; i < MATERIAL_COUNT; i++)
+        materials.append(DefaultMaterial::create());
+
+    QVector<QMatrix4x4> transforms(itemCount);
+    for (int i = 0; i < itemCount; i++)
+        transforms[i].translate(i % 100, (i / 100) % 100, i / 10000);
+
+    RenderList list;
+    QVector3D eyePos(50, 50, -20);
+
+    auto submit = [&]() {
+        list.clear();
+        for (int i = 0; i < itemCount; i++)
+            list.submitMesh(meshes[i % MESH_COUNT], materials[(i / 7) % MATERIAL_COUNT], transforms[i]);
+    };
+
+    // the first frame allocates the blocks, later ones reuse them
+    QElapsedTimer timer;
+    timer.start();
+    submit();
+    double firstSubmit = timer.nsecsElapsed() / 1e6;
+
+    qint64 submitTime = 0;
+    qint64 sortTime = 0;
+    for (int i = 0; i < frameCount; i++) {
+        timer.restart();
+        submit();
+        submitTime += timer.nsecsElapsed();
+
+        timer.restart();
+        list.sort(eyePos);
+        sortTime += timer.nsecsElapsed();
+    }
+
+    auto stats = list.getSortStats();
+
+    printf("%d items, %d frames\n", itemCount, frameCount);
+    printf("first submit: %8.3f ms\n", firstSubmit);
+    printf("submit:       %8.3f ms/frame\n", submitTime / 1e6 / frameCount);
+    printf("sort:         %8.3f ms/frame\n", sortTime / 1e6 / frameCount);
+    printf("material changes: %d before sorting, %d after\n",
+           stats.materialChangesBefore, stats.materialChangesAfter);
+
+    return 0;
+}
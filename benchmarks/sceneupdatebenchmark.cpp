@@ -0,0 +1,126 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Times Scene::update on a large hierarchy when only a few nodes move, when
+// nothing moves and when the top node moves so every transform is recalculated
+// usage: sceneupdatebenchmark [nodes] [depth] [moving nodes] [frames]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtMath>
+#include <cstdio>
+#include <functional>
+
+#include "scenegraph/scene.h"
+#include "scenegraph/scenenode.h"
+#include "graphics/renderlist.h"
+
+using namespace iris;
+
+// levels grow by 4 until the remaining nodes are spread over the last levels,
+// each node's parent is picked evenly from the level above
+static QVector<QVector<SceneNodePtr>> createHierarchy(const SceneNodePtr& top, int nodeCount, int depth)
+{
+    QVector<int> levelSizes;
+    int remaining = nodeCount;
+    for (int level = 0; level < depth; level++) {
+        int levelsLeft = depth - level;
+        qint64 grown = qint64(1) << qMin(2 * (level + 1), 40);
+        int size = int(qMin<qint64>(grown, remaining / levelsLeft));
+        if (level == depth - 1)
+            size = remaining;
+        levelSizes.append(qMax(size, 1));
+        remaining -= levelSizes.last();
+    }
+
+    QVector<QVector<SceneNodePtr>> levels;
+    QVector<SceneNodePtr> parents = { top };
+    for (int size : levelSizes) {
+        QVector<SceneNodePtr> level;
+        for (int i = 0; i < size; i++) {
+            auto node = SceneNode::create();
+            node->setLocalPos(QVector3D(i % 10, 0.1f, 0));
+            parents[qint64(i) * parents.size() / size]->addChild(node, false);
+            level.append(node);
+        }
+        levels.append(level);
+        parents = level;
+    }
+
+    return levels;
+}
+
+// milliseconds per frame
+static double run(const ScenePtr& scene, int frames, const std::function<void(int)>& move)
+{
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    for (int i = 0; i < frames; i++) {
+        move(i);
+
+        timer.restart();
+        scene->update(1.0f / 60.0f);
+        elapsed += timer.nsecsElapsed();
+
+        // the renderer clears these after drawing
+        scene->geometryRenderList->clear();
+        scene->shadowRenderList->clear();
+    }
+
+    return elapsed / 1e6 / frames;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    auto args = app.arguments();
+    int nodeCount = args.size() > 1 ? args[1].toInt() : 100000;
+    int depth = args.size() > 2 ? args[2].toInt() : 10;
+    int movingCount = args.size() > 3 ? args[3].toInt() : 10;
+    int frameCount = args.size() > 4 ? args[4].toInt() : 100;
+
+    auto scene = Scene::create();
+    scene->setParallelUpdateEnabled(false);
+
+    auto top = SceneNode::create();
+    auto levels = createHierarchy(top, nodeCount, depth);
+    scene->getRootNode()->addChild(top, false);
+
+    // spread over the deepest level
+    const auto& leaves = levels.last();
+    QVector<SceneNodePtr> moving;
+    for (int i = 0; i < movingCount && !leaves.isEmpty(); i++)
+        moving.append(leaves[qint64(i) * leaves.size() / movingCount]);
+
+    // the first update calculates every transform
+    run(scene, 1, [](int) {});
+
+    double none = run(scene, frameCount, [](int) {});
+
+    double few = run(scene, frameCount, [&moving](int frame) {
+        for (auto& node : moving)
+            node->setLocalPos(QVector3D(qSin(frame * 0.1f), 0.1f, 0));
+    });
+
+    double all = run(scene, frameCount, [&top](int frame) {
+        top->setLocalPos(QVector3D(qSin(frame * 0.1f), 0, 0));
+    });
+
+    printf("%d nodes, %d levels, %d moving, %d frames\n",
+           nodeCount, int(levels.size()), int(moving.size()), frameCount);
+    printf("nothing moving:   %8.3f ms/frame\n", none);
+    printf("%4d nodes moving: %8.3f ms/frame\n", int(moving.size()), few);
+    printf("full walk:        %8.3f ms/frame\n", all);
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Times Scene::updateSceneAnimation on a crowd of skinned characters with the
+// skeletons evaluated serially and on the thread pool
+// usage: skeletalanimationbenchmark [characters] [bones] [frames]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtMath>
+#include <cstdio>
+
+#include "scenegraph/scene.h"
+#include "scenegraph/scenenode.h"
+#include "scenegraph/meshnode.h"
+#include "graphics/mesh.h"
+#include "graphics/skeleton.h"
+#include "animation/animation.h"
+#include "animation/skeletalanimation.h"
+
+using namespace iris;
+
+static SkeletalAnimationPtr createAnimation(int boneCount)
+{
+    auto skelAnim = SkeletalAnimation::create();
+    skelAnim->name = "sway";
+
+    for (int i = 0; i < boneCount; i++) {
+        auto boneAnim = new BoneAnimation();
+        for (int k = 0; k <= 60; k++) {
+            float t = k / 30.0f;
+            float angle = qSin(t * M_PI + i) * 20.0f;
+            boneAnim->posKeys->addKey(QVector3D(0, 1, 0), t);
+            boneAnim->rotKeys->addKey(QQuaternion::fromEulerAngles(angle, 0, angle * 0.5f), t);
+            boneAnim->scaleKeys->addKey(QVector3D(1, 1, 1), t);
+        }
+        skelAnim->addBoneAnimation(QString("bone%1").arg(i), boneAnim);
+    }
+
+    return skelAnim;
+}
+
+// a chain of bones and a mesh skinned to them, each character has its own
+// skeleton so none of them are grouped together
+static SceneNodePtr createCharacter(const AnimationPtr& animation, int boneCount)
+{
+    auto root = SceneNode::create();
+    root->setName("character");
+
+    auto skeleton = Skeleton::create();
+    BonePtr parentBone;
+    SceneNodePtr parentNode = root;
+    for (int i = 0; i < boneCount; i++) {
+        auto name = QString("bone%1").arg(i);
+
+        auto bone = Bone::create(name);
+        if (!!parentBone)
+            parentBone->addChild(bone);
+        skeleton->addBone(bone);
+        parentBone = bone;
+
+        auto node = SceneNode::create();
+        node->setName(name);
+        parentNode->addChild(node, false);
+        parentNode = node;
+    }
+
+    auto mesh = Mesh::create();
+    mesh->setSkeleton(skeleton);
+
+    auto meshNode = MeshNode::create();
+    meshNode->setName("body");
+    meshNode->setMesh(mesh);
+    root->addChild(meshNode, false);
+
+    root->setAnimation(animation);
+    return root;
+}
+
+// seconds per frame
+static double run(const ScenePtr& scene, int frames)
+{
+    // warm up so the bindings are created outside of the timed frames
+    scene->updateSceneAnimation(0);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < frames; i++)
+        scene->updateSceneAnimation(i / 60.0f);
+
+    return timer.nsecsElapsed() / 1e9 / frames;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    auto args = app.arguments();
+    int characterCount = args.size() > 1 ? args[1].toInt() : 200;
+    int boneCount = args.size() > 2 ? args[2].toInt() : 40;
+    int frameCount = args.size() > 3 ? args[3].toInt() : 300;
+
+    auto animation = Animation::createFromSkeletalAnimation(createAnimation(boneCount));
+    animation->setLooping(true);
+    animation->calculateAnimationLength();
+
+    auto scene = Scene::create();
+    for (int i = 0; i < characterCount; i++) {
+        auto character = createCharacter(animation, boneCount);
+        character->setLocalPos(QVector3D(i % 20, 0, i / 20));
+        scene->getRootNode()->addChild(character, false);
+    }
+
+    printf("%d characters, %d bones, %d frames, %d threads\n",
+           characterCount, boneCount, frameCount, QThread::idealThreadCount());
+    if (QThread::idealThreadCount() < 2)
+        printf("only one thread is available, both runs take the serial path\n");
+
+    scene->setParallelUpdateEnabled(false);
+    double serial = run(scene, frameCount);
+
+    scene->setParallelUpdateEnabled(true);
+    double parallel = run(scene, frameCount);
+
+    printf("serial:   %8.3f ms/frame\n", serial * 1000.0);
+    printf("parallel: %8.3f ms/frame\n", parallel * 1000.0);
+    printf("speedup:  %8.2fx\n", serial / parallel);
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Times the segment-triangle kernels against the TriMesh::intersectSegment
+// loop on one large mesh and checks that they all find the same hits
+// usage: trianglekernelbenchmark [triangles] [queries]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QVector3D>
+#include <QtMath>
+#include <cstdio>
+
+#include "geometry/trimesh.h"
+#include "geometry/trianglekernel.h"
+
+using namespace iris;
+
+// stacked grids facing +z, so a segment going down crosses one triangle per layer
+#define MESH_LAYERS 10
+
+struct Query
+{
+    QVector3D start, end;
+};
+
+struct Result
+{
+    int hits = 0;
+    double tSum = 0;
+};
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    auto args = app.arguments();
+    int triangleCount = args.size() > 1 ? args[1].toInt() : 500000;
+    int queryCount = args.size() > 2 ? args[2].toInt() : 60;
+
+    int side = qMax(1, int(qSqrt(triangleCount / (2.0 * MESH_LAYERS))));
+
+    TriMesh mesh;
+    for (int layer = 0; layer < MESH_LAYERS; layer++) {
+        float z = layer;
+        for (int y = 0; y < side; y++) {
+            for (int x = 0; x < side; x++) {
+                mesh.addTriangle(QVector3D(x, y, z), QVector3D(x + 1, y, z), QVector3D(x, y + 1, z));
+                mesh.addTriangle(QVector3D(x + 1, y, z), QVector3D(x + 1, y + 1, z), QVector3D(x, y + 1, z));
+            }
+        }
+    }
+
+    int count = mesh.triangles.size();
+    QVector<int> order(count);
+    for (int i = 0; i < count; i++)
+        order[i] = i;
+
+    TriangleSoA tris;
+    tris.build(mesh.triangles, order);
+
+    QVector<Query> queries;
+    for (int i = 0; i < queryCount; i++) {
+        // off the grid lines so each layer is hit exactly once
+        float x = fmod(i * 7.31f + 0.37f, float(side));
+        float y = fmod(i * 3.17f + 0.21f, float(side));
+        queries.append({QVector3D(x, y, MESH_LAYERS + 1), QVector3D(x, y, -1)});
+    }
+
+    QVector<int> hitSlots(count);
+    QVector<float> hitTs(count);
+
+    auto runKernel = [&](SegmentTriangleKernel kernel, Result& result) {
+        QElapsedTimer timer;
+        timer.start();
+        for (const auto& query : queries) {
+            int hits = kernel(tris, 0, count, query.start, query.end, hitSlots.data(), hitTs.data());
+            result.hits += hits;
+            for (int i = 0; i < hits; i++)
+                result.tSum += hitTs[i];
+        }
+        return timer.nsecsElapsed() / 1e9;
+    };
+
+    // the loop picking used before the kernels
+    Result loopResult;
+    QElapsedTimer timer;
+    timer.start();
+    for (const auto& query : queries) {
+        for (const auto& tri : mesh.triangles) {
+            float t;
+            if (TriMesh::intersectSegment(tri, query.start, query.end, t)) {
+                loopResult.hits++;
+                loopResult.tSum += t;
+            }
+        }
+    }
+    double loopTime = timer.nsecsElapsed() / 1e9;
+
+    struct Kernel
+    {
+        const char* name;
+        TriangleKernelType type;
+    };
+    Kernel kernels[] = {
+        {"scalar", TriangleKernelType::Scalar},
+        {"sse", TriangleKernelType::SSE},
+        {"avx", TriangleKernelType::AVX}
+    };
+
+    const char* bestName = "scalar";
+    for (const auto& kernel : kernels)
+        if (kernel.type == getBestTriangleKernelType())
+            bestName = kernel.name;
+
+    printf("%d triangles, %d queries, dispatching to %s\n", count, queryCount, bestName);
+    printf("intersectSegment loop: %8.3f s, %d hits\n", loopTime, loopResult.hits);
+
+    Result scalarResult;
+    bool matches = true;
+    for (const auto& kernel : kernels) {
+        auto function = getSegmentTriangleKernel(kernel.type);
+
+        // builds and cpus without the instructions fall back to a narrower kernel
+        bool supported = kernel.type == TriangleKernelType::AVX ?
+                         getBestTriangleKernelType() == TriangleKernelType::AVX :
+                         kernel.type == TriangleKernelType::Scalar ||
+                         function != getSegmentTriangleKernel(TriangleKernelType::Scalar);
+        if (!supported) {
+            printf("%-6s kernel:          unsupported\n", kernel.name);
+            continue;
+        }
+
+        Result result;
+        double time = runKernel(function, result);
+        printf("%-6s kernel:          %8.3f s, %d hits\n", kernel.name, time, result.hits);
+
+        if (kernel.type == TriangleKernelType::Scalar)
+            scalarResult = result;
+        else if (result.hits != scalarResult.hits || result.tSum != scalarResult.tSum)
+            matches = false;
+    }
+
+    // the kernels repeat intersectSegment's operations so even the t values are the same
+    if (scalarResult.hits != loopResult.hits || scalarResult.tSum != loopResult.tSum)
+        matches = false;
+
+    if (!matches) {
+        printf("the kernels found different hits\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #include "keyframeset.h"
 #include "propertyanim.h"
 #include "skeletalanimation.h"
+#include "bakedanimation.h"
 #include "../irisglfwd.h"
 #include <QDebug>
 #include <cmath>
@@ -33,9 +34,36 @@ bool Animation::hasSkeletalAnimation()
 void Animation::setSkeletalAnimation(const SkeletalAnimationPtr &value)
 {
     skeletalAnimation = value;
+    bakedSkeletalAnimation.reset();
     calculateAnimationLength();
 }
 
+void Animation::bakeSkeletalAnimation(bool compressRotations)
+{
+    if (!skeletalAnimation)
+        return;
+
+    // long animations are keyed in milliseconds, see SceneNode::updateAnimation
+    float sampleRate = frameRate;
+    if (length > 60.0f)
+        sampleRate = frameRate / 1000.0f;
+
+    bakedSkeletalAnimation = BakedSkeletalAnimation::create(skeletalAnimation,
+                                                            length,
+                                                            sampleRate,
+                                                            compressRotations);
+}
+
+BakedSkeletalAnimationPtr Animation::getBakedSkeletalAnimation() const
+{
+    return bakedSkeletalAnimation;
+}
+
+bool Animation::hasBakedSkeletalAnimation()
+{
+    return !!bakedSkeletalAnimation;
+}
+
 float Animation::getSampleTime(float time)
 {
     if (loop) {
@@ -72,6 +100,7 @@ Animation::Animation(QString name)
     loop = true;
     length = 1.0f;
     frameRate = 60;
+    propertiesVersion = 0;
 }
 
 Animation::~Animation()
@@ -113,6 +142,7 @@ void Animation::addPropertyAnim(PropertyAnim *anim)
     //Q_ASSERT(!properties.contains(name));
     
     properties.insert(anim->getName(), anim);
+    invalidatePropertyBindings();
     calculateAnimationLength();
 }
 
@@ -123,6 +153,8 @@ void Animation::removePropertyAnim(QString name)
 
     if (properties.remove(name) == 0)
         qDebug() << "Animation property "<<name<<" doesnt exist";
+
+    invalidatePropertyBindings();
 }
 
 PropertyAnim* Animation::getPropertyAnim(QString name)
@@ -152,6 +184,16 @@ bool Animation::hasPropertyAnim(QString name)
     return properties.contains(name);
 }
 
+void Animation::invalidatePropertyBindings()
+{
+    propertiesVersion++;
+}
+
+unsigned int Animation::getPropertiesVersion() const
+{
+    return propertiesVersion;
+}
+
 AnimationPtr Animation::createFromSkeletalAnimation(SkeletalAnimationPtr skelAnim)
 {
     auto anim = new Animation(skelAnim->name);
@@ -35,9 +35,13 @@ class Animation
     // sample rate
     int frameRate;
 
+    // bumped when tracks are added or removed
+    unsigned int propertiesVersion;
+
 public:
     QMap<QString,PropertyAnim*> properties;
     SkeletalAnimationPtr skeletalAnimation;
+    BakedSkeletalAnimationPtr bakedSkeletalAnimation;
 
     explicit Animation(QString name = "Animation");
     ~Animation();
@@ -55,6 +59,11 @@ public:
 
     bool hasPropertyAnim(QString name);
 
+    // Nodes bind to the tracks once, this has to be called if properties
+    // is changed directly instead of through addPropertyAnim and removePropertyAnim
+    void invalidatePropertyBindings();
+    unsigned int getPropertiesVersion() const;
+
     static AnimationPtr create(QString name)
     {
         return AnimationPtr(new Animation(name));
@@ -78,6 +87,12 @@ public:
     bool hasSkeletalAnimation();
     void setSkeletalAnimation(const SkeletalAnimationPtr &value);
 
+    // Resamples the skeletal animation at the frame rate, playback then
+    // uses the baked frames instead of the keyframes
+    void bakeSkeletalAnimation(bool compressRotations = false);
+    BakedSkeletalAnimationPtr getBakedSkeletalAnimation() const;
+    bool hasBakedSkeletalAnimation();
+
     // Calculate the time the animation keyframes should be sampled at
     // It takes looping into consideration
     float getSampleTime(float time);
@@ -0,0 +1,358 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "animationmixer.h"
+#include "animation.h"
+#include "bakedanimation.h"
+#include "skeletalanimation.h"
+#include "skeletonbinding.h"
+#include "keyframeanimation.h"
+#include "../scenegraph/scenenode.h"
+
+#include <utility>
+
+namespace iris
+{
+
+static QQuaternion nlerp(const QQuaternion& a, QQuaternion b, float t)
+{
+    if (QQuaternion::dotProduct(a, b) < 0.0f)
+        b = -b;
+
+    return (a + (b - a) * t).normalized();
+}
+
+AnimationMixer::AnimationMixer()
+{
+    lastTime = 0.0f;
+    hasLastTime = false;
+}
+
+int AnimationMixer::addLayer(float weight, bool additive)
+{
+    Layer layer;
+    layer.weight = weight;
+    layer.additive = additive;
+    layers.append(layer);
+
+    if (!!boundBinding)
+        updateLayerMask(layers.last());
+
+    return layers.size() - 1;
+}
+
+int AnimationMixer::getLayerCount() const
+{
+    return layers.size();
+}
+
+void AnimationMixer::play(int layerIndex, const AnimationPtr& anim, float fadeDuration)
+{
+    auto& layer = layers[layerIndex];
+
+    // an animation that is already fading out is dropped
+    if (fadeDuration > 0.0f) {
+        std::swap(layer.previous, layer.current);
+        layer.fadeTime = 0.0f;
+        layer.fadeDuration = fadeDuration;
+    } else {
+        layer.previous.animation.reset();
+        layer.previous.tracks.reset();
+        layer.fadeDuration = 0.0f;
+    }
+
+    layer.current.animation = anim;
+    layer.current.tracks.reset();
+    layer.current.time = 0.0f;
+}
+
+void AnimationMixer::stop(int layer, float fadeDuration)
+{
+    play(layer, AnimationPtr(), fadeDuration);
+}
+
+void AnimationMixer::setLayerWeight(int layer, float weight)
+{
+    layers[layer].weight = weight;
+}
+
+float AnimationMixer::getLayerWeight(int layer) const
+{
+    return layers[layer].weight;
+}
+
+void AnimationMixer::setLayerAdditive(int layer, bool additive)
+{
+    layers[layer].additive = additive;
+}
+
+void AnimationMixer::setLayerSpeed(int layer, float speed)
+{
+    layers[layer].speed = speed;
+}
+
+void AnimationMixer::setLayerMask(int layerIndex, const QMap<QString, float>& mask, float defaultWeight)
+{
+    auto& layer = layers[layerIndex];
+    layer.mask = mask;
+    layer.defaultMaskWeight = defaultWeight;
+    layer.hasMask = true;
+
+    if (!!boundBinding)
+        updateLayerMask(layer);
+}
+
+void AnimationMixer::clearLayerMask(int layer)
+{
+    layers[layer].mask.clear();
+    layers[layer].hasMask = false;
+}
+
+void AnimationMixer::updateLayerMask(Layer& layer)
+{
+    if (!layer.hasMask)
+        return;
+
+    const auto& nodes = boundBinding->nodes;
+    layer.nodeMask.resize(nodes.size());
+    for (int i = 0; i < nodes.size(); i++)
+        layer.nodeMask[i] = layer.mask.value(nodes[i]->getName(), layer.defaultMaskWeight);
+}
+
+void AnimationMixer::bind(const SkeletonBindingPtr& binding)
+{
+    boundBinding = binding;
+    clipCache.clear();
+
+    const auto& nodes = binding->nodes;
+    int nodeCount = nodes.size();
+
+    restPositions.resize(nodeCount);
+    restRotations.resize(nodeCount);
+    restScales.resize(nodeCount);
+    for (int i = 0; i < nodeCount; i++) {
+        restPositions[i] = nodes[i]->getLocalPos();
+        restRotations[i] = nodes[i]->getLocalRot();
+        restScales[i] = nodes[i]->getLocalScale();
+    }
+
+    posePositions.resize(nodeCount);
+    poseRotations.resize(nodeCount);
+    poseScales.resize(nodeCount);
+    posedNodes.resize(nodeCount);
+
+    for (auto& layer : layers) {
+        layer.current.tracks.reset();
+        layer.previous.tracks.reset();
+        updateLayerMask(layer);
+    }
+}
+
+// Finds or builds the animation's tracks for the bound nodes, returns false for an empty state
+bool AnimationMixer::resolveClip(ClipState& state)
+{
+    if (!state.animation || !state.animation->hasSkeletalAnimation())
+        return false;
+
+    auto anim = state.animation.data();
+    if (!!state.tracks &&
+        state.tracks->skeletalAnimation == anim->getSkeletalAnimation() &&
+        state.tracks->bakedAnimation == anim->getBakedSkeletalAnimation())
+        return true;
+
+    auto& cached = clipCache[anim];
+    if (!cached ||
+        cached->skeletalAnimation != anim->getSkeletalAnimation() ||
+        cached->bakedAnimation != anim->getBakedSkeletalAnimation()) {
+        cached.reset(new ClipTracks());
+        cached->skeletalAnimation = anim->getSkeletalAnimation();
+        cached->bakedAnimation = anim->getBakedSkeletalAnimation();
+
+        const auto& nodes = boundBinding->nodes;
+        int nodeCount = nodes.size();
+        cached->boneAnimations.resize(nodeCount);
+        cached->bakedBoneIndices.resize(nodeCount);
+        cached->referencePositions.resize(nodeCount);
+        cached->referenceRotations.resize(nodeCount);
+        cached->referenceScales.resize(nodeCount);
+
+        for (int i = 0; i < nodeCount; i++) {
+            const auto& name = nodes[i]->name;
+            auto boneAnim = cached->skeletalAnimation->boneAnimations.value(name).data();
+            cached->boneAnimations[i] = boneAnim;
+            cached->bakedBoneIndices[i] = !!cached->bakedAnimation ? cached->bakedAnimation->getBoneIndex(name) : -1;
+
+            if (!!cached->bakedAnimation && cached->bakedBoneIndices[i] != -1) {
+                cached->bakedAnimation->sample(cached->bakedBoneIndices[i], 0.0f,
+                                               cached->referencePositions[i],
+                                               cached->referenceRotations[i],
+                                               cached->referenceScales[i]);
+            } else if (boneAnim != nullptr) {
+                // local cursors, this can run on a worker thread and clips are shared
+                int cursors[3] = {0, 0, 0};
+                cached->referencePositions[i] = boneAnim->posKeys->getValueAt(0.0f, QVector3D(), cursors[0]);
+                cached->referenceRotations[i] = boneAnim->rotKeys->getValueAt(0.0f, QQuaternion(), cursors[1]).normalized();
+                cached->referenceScales[i] = boneAnim->scaleKeys->getValueAt(0.0f, QVector3D(), cursors[2]);
+            }
+        }
+    }
+
+    state.tracks = cached;
+    state.keyCursors.fill(0, boundBinding->nodes.size() * 3);
+    return true;
+}
+
+void AnimationMixer::sampleClip(ClipState& state, int node, QVector3D& pos, QQuaternion& rot, QVector3D& scale)
+{
+    auto tracks = state.tracks.data();
+    if (!!tracks->bakedAnimation) {
+        tracks->bakedAnimation->sample(tracks->bakedBoneIndices[node], state.sampleTime, pos, rot, scale);
+        return;
+    }
+
+    auto boneAnim = tracks->boneAnimations[node];
+    int* cursors = state.keyCursors.data() + node * 3;
+    pos = boneAnim->posKeys->getValueAt(state.sampleTime, QVector3D(), cursors[0]);
+    rot = boneAnim->rotKeys->getValueAt(state.sampleTime, QQuaternion(), cursors[1]).normalized();
+    scale = boneAnim->scaleKeys->getValueAt(state.sampleTime, QVector3D(), cursors[2]);
+}
+
+void AnimationMixer::apply(const SkeletonBindingPtr& binding, float time)
+{
+    evaluate(binding, time);
+    binding->publishTransforms();
+}
+
+void AnimationMixer::evaluate(const SkeletonBindingPtr& binding, float time)
+{
+    if (boundBinding != binding)
+        bind(binding);
+
+    float dt = hasLastTime ? qMax(0.0f, time - lastTime) : 0.0f;
+    lastTime = time;
+    hasLastTime = true;
+
+    int nodeCount = binding->nodes.size();
+    for (int i = 0; i < nodeCount; i++) {
+        posePositions[i] = restPositions[i];
+        poseRotations[i] = restRotations[i];
+        poseScales[i] = restScales[i];
+        posedNodes[i] = 0;
+    }
+
+    for (auto& layer : layers) {
+        layer.current.time += dt * layer.speed;
+        layer.previous.time += dt * layer.speed;
+
+        // weight of the current animation against the one fading out
+        float fade = 1.0f;
+        if (layer.fadeDuration > 0.0f) {
+            layer.fadeTime += dt;
+            if (layer.fadeTime >= layer.fadeDuration) {
+                layer.fadeDuration = 0.0f;
+                layer.previous.animation.reset();
+                layer.previous.tracks.reset();
+            } else {
+                fade = layer.fadeTime / layer.fadeDuration;
+            }
+        }
+
+        bool hasCurrent = resolveClip(layer.current);
+        bool hasPrevious = layer.fadeDuration > 0.0f && resolveClip(layer.previous);
+        if (layer.weight <= 0.0f || (!hasCurrent && !hasPrevious))
+            continue;
+
+        // long animations are keyed in milliseconds, see SceneNode::updateAnimation
+        for (auto state : {&layer.current, &layer.previous}) {
+            if (!state->tracks)
+                continue;
+            auto anim = state->animation.data();
+            float t = anim->getLength() > 60.0f ? state->time * 1000.0f : state->time;
+            state->sampleTime = anim->getSampleTime(t);
+        }
+
+        for (int i = 0; i < nodeCount; i++) {
+            float weight = layer.weight;
+            if (layer.hasMask)
+                weight *= layer.nodeMask[i];
+            if (weight <= 0.0f)
+                continue;
+
+            bool currentTrack = hasCurrent && layer.current.tracks->hasTrack(i);
+            bool previousTrack = hasPrevious && layer.previous.tracks->hasTrack(i);
+            float currentWeight = currentTrack ? fade : 0.0f;
+            float previousWeight = previousTrack ? 1.0f - fade : 0.0f;
+            float total = currentWeight + previousWeight;
+            if (total <= 0.0f)
+                continue;
+
+            QVector3D pos, scale;
+            QQuaternion rot;
+            QVector3D prevPos, prevScale;
+            QQuaternion prevRot;
+            if (currentTrack)
+                sampleClip(layer.current, i, pos, rot, scale);
+            if (previousTrack)
+                sampleClip(layer.previous, i, prevPos, prevRot, prevScale);
+
+            if (layer.additive) {
+                // offsets from each animation's first frame
+                if (currentTrack) {
+                    auto tracks = layer.current.tracks.data();
+                    pos = pos - tracks->referencePositions[i];
+                    rot = rot * tracks->referenceRotations[i].conjugated();
+                    scale = scale / tracks->referenceScales[i];
+                }
+                if (previousTrack) {
+                    auto tracks = layer.previous.tracks.data();
+                    prevPos = prevPos - tracks->referencePositions[i];
+                    prevRot = prevRot * tracks->referenceRotations[i].conjugated();
+                    prevScale = prevScale / tracks->referenceScales[i];
+                }
+            }
+
+            if (currentTrack && previousTrack) {
+                pos = prevPos + (pos - prevPos) * fade;
+                rot = nlerp(prevRot, rot, fade);
+                scale = prevScale + (scale - prevScale) * fade;
+            } else if (previousTrack) {
+                pos = prevPos;
+                rot = prevRot;
+                scale = prevScale;
+            }
+
+            // a track missing from one side of a crossfade fades the node in or out
+            weight *= total;
+
+            if (layer.additive) {
+                posePositions[i] += pos * weight;
+                poseRotations[i] = (nlerp(QQuaternion(), rot, weight) * poseRotations[i]).normalized();
+                poseScales[i] *= QVector3D(1.0f, 1.0f, 1.0f) + (scale - QVector3D(1.0f, 1.0f, 1.0f)) * weight;
+            } else {
+                weight = qMin(weight, 1.0f);
+                posePositions[i] += (pos - posePositions[i]) * weight;
+                poseRotations[i] = nlerp(poseRotations[i], rot, weight);
+                poseScales[i] += (scale - poseScales[i]) * weight;
+            }
+
+            posedNodes[i] = 1;
+        }
+    }
+
+    for (int i = 0; i < nodeCount; i++) {
+        if (posedNodes[i])
+            binding->setNodeTransform(i, posePositions[i], poseRotations[i], poseScales[i]);
+    }
+
+    binding->updateSkeletons();
+}
+
+}
@@ -0,0 +1,146 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef ANIMATIONMIXER_H
+#define ANIMATIONMIXER_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+#include <QVector3D>
+#include <QQuaternion>
+#include <QMap>
+#include <QHash>
+
+namespace iris
+{
+
+class BoneAnimation;
+
+/**
+ * Blends several skeletal animations into one pose.
+ * Layers are applied in order, each one either replacing the pose below it
+ * by its weight or adding its offset from its animation's first frame.
+ * Every layer can crossfade between animations and be limited to some bones
+ * with a mask. Poses are blended per node index of the SkeletonBinding so a
+ * frame doesnt allocate, animations are only resolved to node indices the
+ * first time they're played on a binding.
+ */
+class AnimationMixer
+{
+    AnimationMixer();
+public:
+    static AnimationMixerPtr create()
+    {
+        return AnimationMixerPtr(new AnimationMixer());
+    }
+
+    // returns the index of the new layer
+    int addLayer(float weight = 1.0f, bool additive = false);
+    int getLayerCount() const;
+
+    // crossfades the layer to anim over fadeDuration seconds, a null anim fades the layer out
+    void play(int layer, const AnimationPtr& anim, float fadeDuration = 0.0f);
+    void stop(int layer, float fadeDuration = 0.0f);
+
+    void setLayerWeight(int layer, float weight);
+    float getLayerWeight(int layer) const;
+
+    void setLayerAdditive(int layer, bool additive);
+    void setLayerSpeed(int layer, float speed);
+
+    // weight of each bone by node name, bones missing from the mask use defaultWeight
+    void setLayerMask(int layer, const QMap<QString, float>& mask, float defaultWeight = 0.0f);
+    void clearLayerMask(int layer);
+
+    // advances the layers to time and poses the binding's nodes and skeletons
+    void apply(const SkeletonBindingPtr& binding, float time);
+
+    // apply without publishing, binding->publishTransforms() has to be called after
+    void evaluate(const SkeletonBindingPtr& binding, float time);
+
+private:
+    // an animation resolved to the bound nodes
+    struct ClipTracks
+    {
+        SkeletalAnimationPtr skeletalAnimation;
+        BakedSkeletalAnimationPtr bakedAnimation;
+
+        // per node, null or -1 if the node isnt animated
+        QVector<BoneAnimation*> boneAnimations;
+        QVector<int> bakedBoneIndices;
+
+        // first frame, additive layers apply their offset from it
+        QVector<QVector3D> referencePositions;
+        QVector<QQuaternion> referenceRotations;
+        QVector<QVector3D> referenceScales;
+
+        bool hasTrack(int node) const
+        {
+            return !!bakedAnimation ? bakedBoneIndices[node] != -1 : boneAnimations[node] != nullptr;
+        }
+    };
+
+    struct ClipState
+    {
+        AnimationPtr animation;
+        // shared with clipCache, the cache replaces its entry when the animation changes
+        // while other states can still be using the old one
+        QSharedPointer<ClipTracks> tracks;
+        float time = 0.0f;
+        float sampleTime = 0.0f;
+        QVector<int> keyCursors;
+    };
+
+    struct Layer
+    {
+        float weight = 1.0f;
+        bool additive = false;
+        float speed = 1.0f;
+
+        QMap<QString, float> mask;
+        float defaultMaskWeight = 0.0f;
+        bool hasMask = false;
+        QVector<float> nodeMask;
+
+        // previous is the animation being faded out
+        ClipState current;
+        ClipState previous;
+        float fadeDuration = 0.0f;
+        float fadeTime = 0.0f;
+    };
+
+    QVector<Layer> layers;
+    QHash<Animation*, QSharedPointer<ClipTracks>> clipCache;
+
+    SkeletonBindingPtr boundBinding;
+    float lastTime;
+    bool hasLastTime;
+
+    // pose of the bound nodes when they were bound, layers blend over it
+    QVector<QVector3D> restPositions;
+    QVector<QQuaternion> restRotations;
+    QVector<QVector3D> restScales;
+
+    // the pose being built
+    QVector<QVector3D> posePositions;
+    QVector<QQuaternion> poseRotations;
+    QVector<QVector3D> poseScales;
+    QVector<char> posedNodes;
+
+    void bind(const SkeletonBindingPtr& binding);
+    void updateLayerMask(Layer& layer);
+    bool resolveClip(ClipState& state);
+    void sampleClip(ClipState& state, int node, QVector3D& pos, QQuaternion& rot, QVector3D& scale);
+};
+
+}
+
+#endif // ANIMATIONMIXER_H
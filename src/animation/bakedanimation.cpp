@@ -0,0 +1,135 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "bakedanimation.h"
+#include "skeletalanimation.h"
+#include "keyframeanimation.h"
+
+#include <cmath>
+
+namespace iris
+{
+
+static CompressedQuaternion compressQuaternion(const QQuaternion& q)
+{
+    CompressedQuaternion c;
+    c.x = (qint16)qRound(qBound(-1.0f, q.x(), 1.0f) * 32767.0f);
+    c.y = (qint16)qRound(qBound(-1.0f, q.y(), 1.0f) * 32767.0f);
+    c.z = (qint16)qRound(qBound(-1.0f, q.z(), 1.0f) * 32767.0f);
+    c.w = (qint16)qRound(qBound(-1.0f, q.scalar(), 1.0f) * 32767.0f);
+    return c;
+}
+
+static QQuaternion decompressQuaternion(const CompressedQuaternion& c)
+{
+    const float scale = 1.0f / 32767.0f;
+    return QQuaternion(c.w * scale, c.x * scale, c.y * scale, c.z * scale);
+}
+
+BakedSkeletalAnimation::BakedSkeletalAnimation()
+{
+    sampleRate = 60.0f;
+    length = 0.0f;
+    frameCount = 0;
+}
+
+BakedSkeletalAnimationPtr BakedSkeletalAnimation::create(SkeletalAnimationPtr anim,
+                                                         float length,
+                                                         float sampleRate,
+                                                         bool compressRotations)
+{
+    auto baked = new BakedSkeletalAnimation();
+    baked->name = anim->name;
+    baked->sampleRate = sampleRate;
+    baked->length = qMax(length, 0.0f);
+
+    // one extra frame so the last key is hit exactly
+    int frameCount = (int)std::ceil(baked->length * sampleRate) + 1;
+    baked->frameCount = frameCount;
+
+    int boneCount = anim->boneAnimations.size();
+    baked->boneNames.reserve(boneCount);
+    baked->positions.resize(boneCount * frameCount);
+    baked->scales.resize(boneCount * frameCount);
+    if (compressRotations)
+        baked->compressedRotations.resize(boneCount * frameCount);
+    else
+        baked->rotations.resize(boneCount * frameCount);
+
+    int boneIndex = 0;
+    for (auto iter = anim->boneAnimations.begin(); iter != anim->boneAnimations.end(); iter++) {
+        auto boneAnim = iter.value();
+        baked->boneNames.append(iter.key());
+        baked->boneIndices.insert(iter.key(), boneIndex);
+
+        // each track is sampled forwards so the keyframe cursors do the searching
+        int cursor[3] = {0, 0, 0};
+        QQuaternion prevRot;
+        int base = boneIndex * frameCount;
+        for (int f = 0; f < frameCount; f++) {
+            float time = qMin(f / sampleRate, baked->length);
+
+            auto rot = boneAnim->rotKeys->getValueAt(time, QQuaternion(), cursor[1]).normalized();
+            if (f > 0 && QQuaternion::dotProduct(prevRot, rot) < 0.0f)
+                rot = -rot;
+            prevRot = rot;
+
+            baked->positions[base + f] = boneAnim->posKeys->getValueAt(time, QVector3D(), cursor[0]);
+            baked->scales[base + f] = boneAnim->scaleKeys->getValueAt(time, QVector3D(), cursor[2]);
+            if (compressRotations)
+                baked->compressedRotations[base + f] = compressQuaternion(rot);
+            else
+                baked->rotations[base + f] = rot;
+        }
+
+        boneIndex++;
+    }
+
+    return BakedSkeletalAnimationPtr(baked);
+}
+
+QQuaternion BakedSkeletalAnimation::getRotation(int index) const
+{
+    if (isCompressed())
+        return decompressQuaternion(compressedRotations[index]);
+    return rotations[index];
+}
+
+void BakedSkeletalAnimation::sample(int boneIndex, float time, QVector3D& pos, QQuaternion& rot, QVector3D& scale) const
+{
+    Q_ASSERT(boneIndex >= 0 && boneIndex < boneNames.size());
+
+    float frame = qBound(0.0f, time * sampleRate, (float)(frameCount - 1));
+    int f0 = (int)frame;
+    int f1 = qMin(f0 + 1, frameCount - 1);
+    float t = frame - f0;
+
+    int a = boneIndex * frameCount + f0;
+    int b = boneIndex * frameCount + f1;
+
+    pos = positions[a] + (positions[b] - positions[a]) * t;
+    scale = scales[a] + (scales[b] - scales[a]) * t;
+
+    // nlerp, neighbouring frames are already in the same hemisphere
+    auto ra = getRotation(a);
+    auto rb = getRotation(b);
+    rot = (ra + (rb - ra) * t).normalized();
+}
+
+int BakedSkeletalAnimation::getMemoryUsage() const
+{
+    return positions.size() * sizeof(QVector3D) +
+           scales.size() * sizeof(QVector3D) +
+           rotations.size() * sizeof(QQuaternion) +
+           compressedRotations.size() * sizeof(CompressedQuaternion);
+}
+
+}
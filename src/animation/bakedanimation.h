@@ -0,0 +1,88 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef BAKEDANIMATION_H
+#define BAKEDANIMATION_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+#include <QVector3D>
+#include <QQuaternion>
+#include <QHash>
+
+namespace iris
+{
+
+// quaternion with each component stored as a signed 16 bit fraction
+struct CompressedQuaternion
+{
+    qint16 x, y, z, w;
+};
+
+/**
+ * A SkeletalAnimation resampled at a fixed frame rate.
+ * Each bone's frames are stored contiguously in one array per channel so
+ * sampling is two loads and a lerp instead of a keyframe search.
+ * Rotations are made sign-consistent from one frame to the next while baking
+ * so they can be nlerped without a shortest path check.
+ */
+class BakedSkeletalAnimation
+{
+    BakedSkeletalAnimation();
+public:
+    QString name;
+
+    // frames per unit of key time
+    float sampleRate;
+    float length;
+    int frameCount;
+
+    QVector<QString> boneNames;
+    QHash<QString, int> boneIndices;
+
+    // frame f of bone b is at [b * frameCount + f]
+    QVector<QVector3D> positions;
+    QVector<QVector3D> scales;
+
+    // only one of these is filled
+    QVector<QQuaternion> rotations;
+    QVector<CompressedQuaternion> compressedRotations;
+
+    // sampleRate is the number of frames per unit of key time
+    static BakedSkeletalAnimationPtr create(SkeletalAnimationPtr anim,
+                                            float length,
+                                            float sampleRate,
+                                            bool compressRotations = false);
+
+    bool isCompressed() const
+    {
+        return !compressedRotations.isEmpty();
+    }
+
+    // -1 if the bone isnt animated
+    int getBoneIndex(const QString& boneName) const
+    {
+        return boneIndices.value(boneName, -1);
+    }
+
+    // time is clamped to the length of the animation
+    void sample(int boneIndex, float time, QVector3D& pos, QQuaternion& rot, QVector3D& scale) const;
+
+    // bytes used by the frame data
+    int getMemoryUsage() const;
+
+private:
+    QQuaternion getRotation(int index) const;
+};
+
+}
+
+#endif // BAKEDANIMATION_H
@@ -18,6 +18,9 @@ For more information see the LICENSE file
 #include <QVector4D>
 #include <QQuaternion>
 #include <QColor>
+#include <QVector>
+
+#include <algorithm>
 
 #include "../math/bezierhelper.h"
 
@@ -65,32 +68,41 @@ public:
     }
 };
 
-template <typename T> bool KeyCompare(const Key<T> * const & a, const Key<T> * const & b)
+template <typename T> bool KeyCompare(const Key<T> & a, const Key<T> & b)
+{
+   return a.time < b.time;
+}
+
+template <typename T> bool KeyTimeCompare(double time, const Key<T> & key)
 {
-   return a->time < b->time;
+   return time < key.time;
 }
 
 
+/**
+ * Keys are stored by value and kept sorted by time.
+ * Lookups remember the last interval they landed in so sampling a track
+ * forwards in time only does a binary search when it skips past the next key.
+ * References and pointers to keys are invalidated by addKey, removeKey and sortKeys.
+ */
 template<typename T>
 class KeyFrame
 {
 public:
     QString name;
-    QVector<Key<T>*> keys;
+    QVector<Key<T>> keys;
     float length;//in seconds
 
     KeyFrame()
     {
         length = 15;//for now
+        cursor = 0;
     }
 
     void clear()
     {
-        for (size_t i=0;i<keys.size();i++)
-        {
-            delete keys[i];
-        }
         keys.clear();
+        cursor = 0;
     }
 
     float getLength()
@@ -106,34 +118,30 @@ public:
         //sort keys
         this->sortKeys();
         //get last key and use that to determine length
-        auto last = keys.end().c;
-        length = last->time;
+        length = keys.last().time;
     }
 
-    void removeKey(Key<T>* key)
+    void removeKey(int index)
     {
-        keys.removeOne(key);
+        keys.remove(index);
+        cursor = 0;
     }
 
-    Key<T>* addKey(T value,double time)
+    // inserts the key after any existing keys with the same time
+    Key<T>& addKey(T value,double time)
     {
-        auto key = new Key<T>();
-        key->value = value;
-        key->time = time;
-        keys.push_back(key);
-
-        // if the new key's time isnt greater than the last key's time,
-        // do a sort
-        if(keys.size() >= 2 &&
-           keys[keys.size()-2]->time > keys[keys.size()-1]->time)
-        {
-            this->sortKeys();
-        }
+        Key<T> key = Key<T>();
+        key.value = value;
+        key.time = time;
+
+        auto iter = std::upper_bound(keys.begin(), keys.end(), time, KeyTimeCompare<T>);
+        int index = iter - keys.begin();
+        keys.insert(index, key);
 
         // update length
-        length = keys[keys.size() - 1]->time;
+        length = keys.last().time;
 
-        return key;
+        return keys[index];
     }
 
     bool hasKeys()
@@ -148,51 +156,42 @@ public:
 
     T getValueAt(double time,T defaultVal)
     {
-        Key<T>* leftKey = Q_NULLPTR;
-        Key<T>* rightKey = Q_NULLPTR;
+        return getValueAt(time, defaultVal, cursor);
+    }
 
-        //why bother with a copy?
-        T val = defaultVal;
+    // samples with a caller owned cursor, for sharing a track between several players
+    T getValueAt(double time,T defaultVal,int& keyCursor)
+    {
+        const Key<T>* leftKey = Q_NULLPTR;
+        const Key<T>* rightKey = Q_NULLPTR;
 
-        this->getKeyFramesAtTime(&leftKey,&rightKey,time);
+        this->getKeyFramesAtTime(&leftKey,&rightKey,time,keyCursor);
 
-        if(leftKey!=Q_NULLPTR && rightKey==Q_NULLPTR)
-        {
-            val = leftKey->value;
-        }
+        if(leftKey==Q_NULLPTR)
+            return defaultVal;
 
-        if(leftKey!=Q_NULLPTR && rightKey!=Q_NULLPTR)
+        if(rightKey==Q_NULLPTR)
+            return leftKey->value;
+
+        //linearly interpolate between frames
+        float t =0;
+        float timeDiff = rightKey->time - leftKey->time;
+
+        //frameDiff could be 0!!
+        if(timeDiff != 0)
         {
-            //linearly interpolate between frames
-            //float t =0;
-            float timeDiff = rightKey->time - leftKey->time;
-
-            //frameDiff could be 0!!
-            if(timeDiff != 0)
-            {
-                //t = (time-leftKey->time)/timeDiff;
-            }
-
-            if(leftKey!=Q_NULLPTR && rightKey!=Q_NULLPTR)
-            {
-                //linearly interpolate between frames
-                float t =0;
-                float timeDiff = rightKey->time - leftKey->time;
-
-                //frameDiff could be 0!!
-                if(timeDiff != 0)
-                {
-                    t = (time-leftKey->time)/timeDiff;
-                }
-
-                val = interpolate(leftKey->value, rightKey->value, t);
-            }
+            t = (time-leftKey->time)/timeDiff;
         }
 
-        return val;
+        return interpolate(leftKey->value, rightKey->value, t);
+    }
+
+    void getKeyFramesAtTime(const Key<T>** firstKey,const Key<T>** lastKey,float time)
+    {
+        getKeyFramesAtTime(firstKey, lastKey, time, cursor);
     }
 
-    void getKeyFramesAtTime(Key<T>** firstKey,Key<T>** lastKey,float time)
+    void getKeyFramesAtTime(const Key<T>** firstKey,const Key<T>** lastKey,float time,int& keyCursor) const
     {
         int numKeys = keys.size();
 
@@ -201,69 +200,83 @@ public:
 
         if(numKeys==1)
         {
-            *firstKey = keys[0];
+            *firstKey = &keys[0];
             return;
         }
 
         //before first key
         //todo: wrap around
-        if(time<=keys[0]->time)
+        if(time<=keys[0].time)
         {
-            *firstKey = keys[0];
+            *firstKey = &keys[0];
             return;
         }
 
         //after last key
         //todo: wrap around
-        if(time>=keys[numKeys-1]->time)
+        if(time>=keys[numKeys-1].time)
         {
-            *firstKey = keys[numKeys-1];
+            *firstKey = &keys[numKeys-1];
             return;
         }
 
-        //find first key and last key
-        for(size_t k = 0;k<keys.size();k++)
+        // the first key is the last one at or before time, check the
+        // cached interval and the one after it before searching
+        int k = keyCursor;
+        if(k < 0 || k >= numKeys - 1 || keys[k].time > time)
         {
-            Key<T>* key = keys[k];
-
-            if(key->time<=time)
-                *firstKey = key;
+            k = findKey(time);
+        }
+        else if(keys[k + 1].time <= time)
+        {
+            if(k + 2 < numKeys && keys[k + 2].time > time)
+                k = k + 1;
             else
-            {
-                *lastKey = key;
-                break;
-            }
+                k = findKey(time);
         }
 
+        keyCursor = k;
+        *firstKey = &keys[k];
+        *lastKey = &keys[k + 1];
     }
 
     void sortKeys()
     {
-        std::sort(keys.begin(),keys.end(),KeyCompare<T>);
+        std::stable_sort(keys.begin(),keys.end(),KeyCompare<T>);
+        cursor = 0;
     }
 
     double getFirstKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.begin().time;
+        return keys.first().time;
     }
 
     double getLastKeyTime()
     {
         Q_ASSERT(keys.size()>0);
 
-        return keys.end().time;
+        return keys.last().time;
     }
 
     virtual ~KeyFrame()
     {
-        for(auto iter = keys.begin();iter!=keys.end();iter++)
-            delete *iter;
     }
 
 protected:
     virtual T interpolate(T a,T b,float t)=0;
+
+private:
+    // index of the last key at or before time, time must be within the keys' range
+    int findKey(float time) const
+    {
+        auto iter = std::upper_bound(keys.constBegin(), keys.constEnd(), (double)time, KeyTimeCompare<T>);
+        return (iter - keys.constBegin()) - 1;
+    }
+
+    // interval used by the last lookup
+    int cursor;
 };
 
 
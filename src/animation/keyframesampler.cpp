@@ -0,0 +1,196 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "keyframesampler.h"
+#include "keyframeanimation.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KEYFRAMESAMPLER_SSE
+#include <emmintrin.h>
+#endif
+
+// samples interpolated per batch, keeps the scratch arrays on the stack
+#define KEYFRAMESAMPLER_BATCH_SIZE 64
+
+namespace iris
+{
+
+// the keys a batch of samples interpolate between, one entry per sample
+struct SegmentBatch
+{
+    float from[KEYFRAMESAMPLER_BATCH_SIZE];
+    float to[KEYFRAMESAMPLER_BATCH_SIZE];
+    float duration[KEYFRAMESAMPLER_BATCH_SIZE];
+    double startTime[KEYFRAMESAMPLER_BATCH_SIZE];
+    double time[KEYFRAMESAMPLER_BATCH_SIZE];
+
+    // all bits set when the sample is just from, i.e. getValueAt returns a key as is
+    unsigned int hold[KEYFRAMESAMPLER_BATCH_SIZE];
+
+    void set(int i, double sampleTime, const Key<float>* leftKey, const Key<float>* rightKey, float defaultValue)
+    {
+        time[i] = sampleTime;
+
+        if (leftKey == nullptr || rightKey == nullptr) {
+            from[i] = to[i] = leftKey != nullptr ? leftKey->value : defaultValue;
+            duration[i] = 0.0f;
+            startTime[i] = sampleTime;
+            hold[i] = 0xffffffffu;
+            return;
+        }
+
+        // same conversions as KeyFrame::getValueAt
+        from[i] = leftKey->value;
+        to[i] = rightKey->value;
+        duration[i] = rightKey->time - leftKey->time;
+        startTime[i] = leftKey->time;
+        hold[i] = 0;
+    }
+};
+
+static inline float interpolateSample(const SegmentBatch& batch, int i)
+{
+    if (batch.hold[i])
+        return batch.from[i];
+
+    float t = 0;
+    if (batch.duration[i] != 0)
+        t = (batch.time[i] - batch.startTime[i]) / batch.duration[i];
+
+    return batch.from[i] + (batch.to[i] - batch.from[i]) * t;
+}
+
+// the interpolation is done in the same precision as the scalar path so the results match
+static void interpolateBatch(const SegmentBatch& batch, int count, float* values)
+{
+    int i = 0;
+
+#ifdef KEYFRAMESAMPLER_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 from = _mm_loadu_ps(batch.from + i);
+        __m128 to = _mm_loadu_ps(batch.to + i);
+        __m128 duration = _mm_loadu_ps(batch.duration + i);
+        __m128 hold = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(batch.hold + i)));
+
+        // zero length segments use t = 0, divide those by 1 instead
+        __m128 hasDuration = _mm_cmpneq_ps(duration, zero);
+        duration = _mm_or_ps(_mm_and_ps(hasDuration, duration), _mm_andnot_ps(hasDuration, one));
+
+        __m128d elapsedLo = _mm_sub_pd(_mm_loadu_pd(batch.time + i), _mm_loadu_pd(batch.startTime + i));
+        __m128d elapsedHi = _mm_sub_pd(_mm_loadu_pd(batch.time + i + 2), _mm_loadu_pd(batch.startTime + i + 2));
+        __m128d tLo = _mm_div_pd(elapsedLo, _mm_cvtps_pd(duration));
+        __m128d tHi = _mm_div_pd(elapsedHi, _mm_cvtps_pd(_mm_movehl_ps(duration, duration)));
+
+        __m128 t = _mm_movelh_ps(_mm_cvtpd_ps(tLo), _mm_cvtpd_ps(tHi));
+        t = _mm_and_ps(t, hasDuration);
+
+        __m128 value = _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), t));
+        value = _mm_or_ps(_mm_and_ps(hold, from), _mm_andnot_ps(hold, value));
+
+        _mm_storeu_ps(values + i, value);
+    }
+#endif
+
+    for (; i < count; i++)
+        values[i] = interpolateSample(batch, i);
+}
+
+void sampleKeyFrame(const FloatKeyFrame* keyFrame,
+                    const float* times,
+                    float* values,
+                    int count,
+                    float defaultValue)
+{
+    SegmentBatch batch;
+    int cursor = 0;
+
+    for (int start = 0; start < count; start += KEYFRAMESAMPLER_BATCH_SIZE) {
+        int batchCount = qMin(count - start, KEYFRAMESAMPLER_BATCH_SIZE);
+
+        for (int i = 0; i < batchCount; i++) {
+            const Key<float>* leftKey = nullptr;
+            const Key<float>* rightKey = nullptr;
+            float time = times[start + i];
+
+            keyFrame->getKeyFramesAtTime(&leftKey, &rightKey, time, cursor);
+            batch.set(i, time, leftKey, rightKey, defaultValue);
+        }
+
+        interpolateBatch(batch, batchCount, values + start);
+    }
+}
+
+// true if b's lookup would land on the same keys as a's did
+static bool hasSameSegment(const FloatKeyFrame* a, const FloatKeyFrame* b, int keyIndex, bool hasRightKey)
+{
+    int numKeys = a->keys.size();
+    if (b->keys.size() != numKeys)
+        return false;
+
+    if (numKeys == 0)
+        return true;
+
+    // the first and last keys decide whether the time is clamped, the
+    // interval keys decide which interval is picked
+    if (a->keys[0].time != b->keys[0].time ||
+        a->keys[numKeys - 1].time != b->keys[numKeys - 1].time ||
+        a->keys[keyIndex].time != b->keys[keyIndex].time)
+        return false;
+
+    return !hasRightKey || a->keys[keyIndex + 1].time == b->keys[keyIndex + 1].time;
+}
+
+void sampleKeyFrames(FloatKeyFrame* const* keyFrames,
+                     int count,
+                     float time,
+                     float* values,
+                     float defaultValue)
+{
+    SegmentBatch batch;
+
+    for (int start = 0; start < count; start += KEYFRAMESAMPLER_BATCH_SIZE) {
+        int batchCount = qMin(count - start, KEYFRAMESAMPLER_BATCH_SIZE);
+
+        // track whose lookup the next ones try to reuse
+        const FloatKeyFrame* searched = nullptr;
+        int keyIndex = 0;
+        bool hasRightKey = false;
+
+        for (int i = 0; i < batchCount; i++) {
+            FloatKeyFrame* keyFrame = keyFrames[start + i];
+            const Key<float>* leftKey = nullptr;
+            const Key<float>* rightKey = nullptr;
+
+            if (searched != nullptr && hasSameSegment(searched, keyFrame, keyIndex, hasRightKey)) {
+                if (!keyFrame->keys.isEmpty()) {
+                    leftKey = keyFrame->keys.constData() + keyIndex;
+                    if (hasRightKey)
+                        rightKey = leftKey + 1;
+                }
+            } else {
+                keyFrame->getKeyFramesAtTime(&leftKey, &rightKey, time);
+
+                searched = keyFrame;
+                keyIndex = leftKey != nullptr ? int(leftKey - keyFrame->keys.constData()) : 0;
+                hasRightKey = rightKey != nullptr;
+            }
+
+            batch.set(i, time, leftKey, rightKey, defaultValue);
+        }
+
+        interpolateBatch(batch, batchCount, values + start);
+    }
+}
+
+}
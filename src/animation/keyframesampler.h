@@ -0,0 +1,49 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef KEYFRAMESAMPLER_H
+#define KEYFRAMESAMPLER_H
+
+namespace iris
+{
+
+class FloatKeyFrame;
+
+/*
+ * Batch versions of FloatKeyFrame::getValueAt. Key lookups are done first,
+ * then the interpolation runs four samples at a time. Every value is bit
+ * for bit what getValueAt would have returned.
+ */
+
+/*
+ * Samples one track at count times, for drawing curves in the timeline.
+ * Sorted times are fastest since each lookup starts from the previous one.
+ * Doesn't move the track's own cursor
+ */
+void sampleKeyFrame(const FloatKeyFrame* keyFrame,
+                    const float* times,
+                    float* values,
+                    int count,
+                    float defaultValue = 0.0f);
+
+/*
+ * Samples count tracks at the same time, e.g. the x, y and z of a vector.
+ * Tracks with the same key times as the one before them reuse its lookup
+ */
+void sampleKeyFrames(FloatKeyFrame* const* keyFrames,
+                     int count,
+                     float time,
+                     float* values,
+                     float defaultValue = 0.0f);
+
+}
+
+#endif // KEYFRAMESAMPLER_H
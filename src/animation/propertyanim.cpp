@@ -1,5 +1,6 @@
 #include "propertyanim.h"
 #include "keyframeanimation.h"
+#include "keyframesampler.h"
 
 namespace iris{
 
@@ -54,11 +55,11 @@ Vector3DPropertyAnim::~Vector3DPropertyAnim()
 
 QVector3D Vector3DPropertyAnim::getValue(float time)
 {
-    return QVector3D(
-                keyFrames[0]->getValueAt(time),
-                keyFrames[1]->getValueAt(time),
-                keyFrames[2]->getValueAt(time)
-                );
+    // one key lookup for all three when they're keyed together
+    float values[3];
+    sampleKeyFrames(keyFrames, 3, time, values);
+
+    return QVector3D(values[0], values[1], values[2]);
 }
 
 QList<PropertyAnimInfo> Vector3DPropertyAnim::getKeyFrames()
@@ -106,11 +107,14 @@ ColorPropertyAnim::~ColorPropertyAnim()
 
 QColor ColorPropertyAnim::getValue(float time)
 {
+    float values[4];
+    sampleKeyFrames(keyFrames, 4, time, values);
+
     return QColor(
-                keyFrames[0]->getValueAt(time) * 255,
-                keyFrames[1]->getValueAt(time) * 255,
-                keyFrames[2]->getValueAt(time) * 255,
-                keyFrames[3]->getValueAt(time) * 255
+                values[0] * 255,
+                values[1] * 255,
+                values[2] * 255,
+                values[3] * 255
                 );
 }
 
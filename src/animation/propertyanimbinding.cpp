@@ -0,0 +1,55 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "propertyanimbinding.h"
+#include "animation.h"
+#include "../scenegraph/scenenode.h"
+
+namespace iris
+{
+
+PropertyAnimBindingPtr PropertyAnimBinding::create(SceneNode* node, const AnimationPtr& animation)
+{
+    auto binding = new PropertyAnimBinding();
+    binding->animation = animation;
+    binding->propertiesVersion = !!animation ? animation->getPropertiesVersion() : 0;
+
+    if (!!animation && !animation->properties.isEmpty())
+        node->bindPropertyAnims(binding);
+
+    return PropertyAnimBindingPtr(binding);
+}
+
+bool PropertyAnimBinding::isBoundTo(const AnimationPtr& animation) const
+{
+    if (this->animation != animation)
+        return false;
+
+    return !animation || propertiesVersion == animation->getPropertiesVersion();
+}
+
+void PropertyAnimBinding::bind(const QString& name, Setter setter, bool usesRawTime)
+{
+    // value() so missing names arent inserted into the map
+    auto anim = animation->properties.value(name, nullptr);
+    if (anim == nullptr)
+        return;
+
+    tracks.append({anim, setter, usesRawTime});
+}
+
+void PropertyAnimBinding::apply(SceneNode* node, float sampleTime, float rawTime) const
+{
+    for (const auto& track : tracks)
+        track.setter(node, track.anim, track.usesRawTime ? rawTime : sampleTime);
+}
+
+}
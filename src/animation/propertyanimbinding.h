@@ -0,0 +1,64 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PROPERTYANIMBINDING_H
+#define PROPERTYANIMBINDING_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+
+namespace iris
+{
+
+class PropertyAnim;
+
+/**
+ * The property tracks of an animation resolved against a node.
+ * Each animated property's track and setter are looked up by name once when
+ * binding, so a frame only visits the properties the animation has.
+ * The binding is rebuilt when tracks are added to or removed from the
+ * animation, see Animation::invalidatePropertyBindings().
+ */
+class PropertyAnimBinding
+{
+    PropertyAnimBinding(){}
+public:
+    // writes the track's value at time into the node
+    typedef void (*Setter)(SceneNode* node, PropertyAnim* anim, float time);
+
+    struct Track
+    {
+        PropertyAnim* anim;
+        Setter setter;
+        // sampled with the time given to updateAnimation instead of the looped sample time
+        bool usesRawTime;
+    };
+
+    // what the binding was resolved against
+    AnimationPtr animation;
+    unsigned int propertiesVersion;
+
+    QVector<Track> tracks;
+
+    // the node adds a track for each property it knows how to animate
+    static PropertyAnimBindingPtr create(SceneNode* node, const AnimationPtr& animation);
+
+    bool isBoundTo(const AnimationPtr& animation) const;
+
+    // adds a track if the animation has one called name
+    void bind(const QString& name, Setter setter, bool usesRawTime = false);
+
+    void apply(SceneNode* node, float sampleTime, float rawTime) const;
+};
+
+}
+
+#endif // PROPERTYANIMBINDING_H
@@ -0,0 +1,193 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "skeletonbinding.h"
+#include "animation.h"
+#include "bakedanimation.h"
+#include "skeletalanimation.h"
+#include "keyframeanimation.h"
+#include "../scenegraph/scenenode.h"
+#include "../scenegraph/meshnode.h"
+#include "../graphics/mesh.h"
+#include "../graphics/skeleton.h"
+
+#include <QHash>
+
+namespace iris
+{
+
+SkeletonBindingPtr SkeletonBinding::create(SceneNode* root, const AnimationPtr& animation)
+{
+    auto binding = new SkeletonBinding();
+    if (!!animation) {
+        binding->skeletalAnimation = animation->getSkeletalAnimation();
+        binding->bakedAnimation = animation->getBakedSkeletalAnimation();
+    }
+
+    auto skelAnim = binding->skeletalAnimation;
+    auto baked = binding->bakedAnimation;
+
+    // flatten the hierarchy depth first, the same order it was walked in before
+    QVector<SceneNode*> stack;
+    QVector<int> stackParents;
+    stack.append(root);
+    stackParents.append(-1);
+    while (!stack.isEmpty()) {
+        auto node = stack.takeLast();
+        int parent = stackParents.takeLast();
+
+        int index = binding->nodes.size();
+        binding->nodes.append(node);
+        binding->parents.append(parent);
+        binding->boneAnimations.append(!!skelAnim ? skelAnim->boneAnimations.value(node->name).data() : nullptr);
+        binding->bakedBoneIndices.append(!!baked ? baked->getBoneIndex(node->name) : -1);
+
+        for (int i = node->children.size() - 1; i >= 0; i--) {
+            stack.append(node->children[i].data());
+            stackParents.append(index);
+        }
+    }
+
+    binding->keyCursors.fill(0, binding->nodes.size() * 3);
+    binding->posedNodes.fill(0, binding->nodes.size());
+    binding->skeletonSpaceMatrices.resize(binding->nodes.size());
+
+    binding->hasNestedAnimations = false;
+    for (int i = 1; i < binding->nodes.size(); i++)
+        if (!!binding->nodes[i]->getAnimation() || !!binding->nodes[i]->getAnimationMixer())
+            binding->hasNestedAnimations = true;
+
+    // later nodes win when names are repeated
+    QHash<QString, int> nodeIndices;
+    for (int i = 0; i < binding->nodes.size(); i++)
+        nodeIndices.insert(binding->nodes[i]->name, i);
+
+    for (auto node : binding->nodes) {
+        if (node->sceneNodeType != SceneNodeType::Mesh)
+            continue;
+
+        auto mesh = static_cast<MeshNode*>(node)->getMesh();
+        if (mesh == nullptr || !mesh->hasSkeleton())
+            continue;
+
+        SkinnedMesh skinned;
+        skinned.meshNode = static_cast<MeshNode*>(node);
+        skinned.nodeIndex = nodeIndices.value(node->name);
+        skinned.skeleton = mesh->getSkeleton().data();
+        for (auto bone : skinned.skeleton->bones)
+            skinned.boneNodeIndices.append(nodeIndices.value(bone->name, -1));
+
+        binding->skinnedMeshes.append(skinned);
+    }
+
+    return SkeletonBindingPtr(binding);
+}
+
+bool SkeletonBinding::isBoundTo(const AnimationPtr& animation) const
+{
+    if (!animation)
+        return !skeletalAnimation && !bakedAnimation;
+
+    return skeletalAnimation == animation->getSkeletalAnimation() &&
+           bakedAnimation == animation->getBakedSkeletalAnimation();
+}
+
+void SkeletonBinding::applyAnimation(float time)
+{
+    evaluatePose(time, true);
+    publishTransforms();
+}
+
+void SkeletonBinding::evaluate(float time)
+{
+    evaluatePose(time, true);
+}
+
+void SkeletonBinding::updateSkeletons()
+{
+    evaluatePose(0.0f, false);
+}
+
+void SkeletonBinding::setNodeTransform(int index, const QVector3D& pos, const QQuaternion& rot, const QVector3D& scale)
+{
+    auto node = nodes[index];
+    node->pos = pos;
+    node->rot = rot;
+    node->scale = scale;
+    node->setSubtreeTransformDirty();
+    posedNodes[index] = 1;
+}
+
+void SkeletonBinding::publishTransforms()
+{
+    for (int i = 0; i < nodes.size(); i++) {
+        if (posedNodes[i]) {
+            nodes[i]->propagateTransformDirty();
+            posedNodes[i] = 0;
+        }
+    }
+
+    flagSkinnedMeshes();
+}
+
+void SkeletonBinding::flagSkinnedMeshes()
+{
+    // cpu skinned meshes recalculate their bounds from the new pose in update()
+    for (const auto& skinned : skinnedMeshes)
+        if (skinned.meshNode->isCpuSkinningEnabled())
+            skinned.meshNode->setHasDirtyChildren();
+}
+
+void SkeletonBinding::applyCurrentPose()
+{
+    updateSkeletons();
+    flagSkinnedMeshes();
+}
+
+void SkeletonBinding::evaluatePose(float time, bool animate)
+{
+    // taken before the root is animated
+    auto rootTransform = nodes[0]->getLocalTransform();
+
+    for (int i = 0; i < nodes.size(); i++) {
+        auto node = nodes[i];
+
+        if (animate) {
+            if (!!bakedAnimation) {
+                if (bakedBoneIndices[i] != -1) {
+                    bakedAnimation->sample(bakedBoneIndices[i], time, node->pos, node->rot, node->scale);
+                    node->setSubtreeTransformDirty();
+                    posedNodes[i] = 1;
+                }
+            }
+            else if (boneAnimations[i] != nullptr) {
+                auto boneAnim = boneAnimations[i];
+                int* cursors = keyCursors.data() + i * 3;
+                node->pos = boneAnim->posKeys->getValueAt(time, QVector3D(), cursors[0]);
+                node->rot = boneAnim->rotKeys->getValueAt(time, QQuaternion(), cursors[1]).normalized();
+                node->scale = boneAnim->scaleKeys->getValueAt(time, QVector3D(), cursors[2]);
+                node->setSubtreeTransformDirty();
+                posedNodes[i] = 1;
+            }
+        }
+
+        // skeleton space transform
+        const auto& parentTransform = parents[i] == -1 ? rootTransform : skeletonSpaceMatrices[parents[i]];
+        skeletonSpaceMatrices[i] = parentTransform * node->getLocalTransform();
+    }
+
+    for (const auto& skinned : skinnedMeshes) {
+        auto inverseMeshMatrix = skeletonSpaceMatrices[skinned.nodeIndex].inverted();
+        skinned.skeleton->applyAnimation(inverseMeshMatrix, skeletonSpaceMatrices, skinned.boneNodeIndices);
+    }
+}
+
+}
@@ -0,0 +1,106 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SKELETONBINDING_H
+#define SKELETONBINDING_H
+
+#include "../irisglfwd.h"
+#include <QVector>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QQuaternion>
+
+namespace iris
+{
+
+class BoneAnimation;
+
+/**
+ * A skeletal animation resolved against the hierarchy under an animated node.
+ * Bone names are matched to nodes and skeleton bones once when binding, so
+ * evaluating a frame is a loop over parent-before-child arrays with no name
+ * lookups or allocations.
+ * The binding is rebuilt when the hierarchy, a mesh or the animation changes.
+ */
+class SkeletonBinding
+{
+    SkeletonBinding(){}
+public:
+    struct SkinnedMesh
+    {
+        MeshNode* meshNode;
+
+        // node whose skeleton space matrix is the mesh's root
+        int nodeIndex;
+        Skeleton* skeleton;
+
+        // node driving each bone of the skeleton, -1 if there isnt one
+        QVector<int> boneNodeIndices;
+    };
+
+    // what the binding was resolved against, both null when bound without an animation
+    SkeletalAnimationPtr skeletalAnimation;
+    BakedSkeletalAnimationPtr bakedAnimation;
+
+    // the animated node and its descendants, parents always come before their children
+    QVector<SceneNode*> nodes;
+    QVector<int> parents;
+
+    // per node, null or -1 if the node isnt animated
+    QVector<BoneAnimation*> boneAnimations;
+    QVector<int> bakedBoneIndices;
+
+    // position, rotation and scale key cursors per node, clips are shared
+    // between characters so each binding keeps its own
+    QVector<int> keyCursors;
+
+    // nodes written since the last publishTransforms
+    QVector<char> posedNodes;
+
+    QVector<QMatrix4x4> skeletonSpaceMatrices;
+    QVector<SkinnedMesh> skinnedMeshes;
+
+    // a node below the root has its own animation
+    bool hasNestedAnimations;
+
+    static SkeletonBindingPtr create(SceneNode* root, const AnimationPtr& animation);
+
+    bool isBoundTo(const AnimationPtr& animation) const;
+
+    // samples the animation at time into the nodes then poses the skeletons
+    void applyAnimation(float time);
+
+    // poses the skeletons using the nodes' current transforms
+    void applyCurrentPose();
+
+    /*
+     * applyAnimation split in two for running bindings in parallel.
+     * evaluate only writes to the bound nodes and skeletons, publishTransforms
+     * then flags the changed nodes to the rest of the scene and must be called
+     * from one thread
+     */
+    void evaluate(float time);
+    void publishTransforms();
+
+    // for poses computed elsewhere, such as by an AnimationMixer. Both are
+    // safe to call from the thread evaluating this binding
+    void setNodeTransform(int index, const QVector3D& pos, const QQuaternion& rot, const QVector3D& scale);
+    // recalculates the skeleton space matrices and skeletons from the nodes
+    void updateSkeletons();
+
+private:
+    void evaluatePose(float time, bool animate);
+    void flagSkinnedMeshes();
+};
+
+}
+
+#endif // SKELETONBINDING_H
@@ -22,6 +22,13 @@ void AABB::setNegativeInfinity()
 		-std::numeric_limits<float>::max());
 }
 
+bool AABB::isNull() const
+{
+	return minPos.x() > maxPos.x() ||
+		minPos.y() > maxPos.y() ||
+		minPos.z() > maxPos.z();
+}
+
 QVector3D AABB::getMin(const QVector3D& a, const QVector3D& b) const
 {
 	QVector3D result;
@@ -105,4 +112,27 @@ BoundingSphere AABB::getMinimalEnclosingSphere() const
 	return { getCenter(), getSize().length() * 0.5f };
 }
 
+// Graphics Gems, "Transforming Axis-Aligned Bounding Boxes" (Arvo)
+// the transformed extents are the half size projected onto the absolute basis vectors
+AABB AABB::transformed(const QMatrix4x4& matrix) const
+{
+	if (isNull())
+		return AABB();
+
+	auto center = matrix * getCenter();
+	auto halfSize = getHalfSize();
+
+	QVector3D extents;
+	for (int i = 0; i < 3; i++) {
+		extents[i] = qAbs(matrix(i, 0)) * halfSize.x() +
+					 qAbs(matrix(i, 1)) * halfSize.y() +
+					 qAbs(matrix(i, 2)) * halfSize.z();
+	}
+
+	AABB result;
+	result.minPos = center - extents;
+	result.maxPos = center + extents;
+	return result;
+}
+
 }
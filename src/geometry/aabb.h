@@ -1,6 +1,7 @@
 #pragma once
 #include <QVector>
 #include <QVector3D>
+#include <QMatrix4x4>
 #include "boundingsphere.h"
 
 namespace iris
@@ -16,6 +17,9 @@ public:
 
 	void setNegativeInfinity();
 
+	// true if nothing has been merged into the box yet
+	bool isNull() const;
+
 	QVector3D getMin() const { return minPos; }
 	QVector3D getMax() const { return maxPos; }
 
@@ -37,6 +41,9 @@ public:
 
 	BoundingSphere getMinimalEnclosingSphere() const;
 
+	// returns the box enclosing this box after it has been transformed by matrix
+	AABB transformed(const QMatrix4x4& matrix) const;
+
 	static AABB fromPoints(const QVector<QVector3D>& points);
 
 private:
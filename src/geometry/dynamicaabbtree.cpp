@@ -0,0 +1,399 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "dynamicaabbtree.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+
+// fraction of a proxy's size it can move before it gets reinserted
+#define DYNAMIC_AABB_TREE_MARGIN 0.1f
+
+namespace iris
+{
+
+static float surfaceArea(const AABB& box)
+{
+    auto size = box.getSize();
+    return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+static AABB combine(const AABB& a, const AABB& b)
+{
+    AABB box = a;
+    box.merge(b);
+    return box;
+}
+
+static bool contains(const AABB& outer, const AABB& inner)
+{
+    auto outerMin = outer.getMin();
+    auto outerMax = outer.getMax();
+    auto innerMin = inner.getMin();
+    auto innerMax = inner.getMax();
+
+    return outerMin.x() <= innerMin.x() && outerMin.y() <= innerMin.y() && outerMin.z() <= innerMin.z() &&
+           innerMax.x() <= outerMax.x() && innerMax.y() <= outerMax.y() && innerMax.z() <= outerMax.z();
+}
+
+static AABB fatten(const AABB& bounds)
+{
+    auto margin = bounds.getSize() * DYNAMIC_AABB_TREE_MARGIN + QVector3D(0.01f, 0.01f, 0.01f);
+
+    AABB box;
+    box.merge(bounds.getMin() - margin);
+    box.merge(bounds.getMax() + margin);
+    return box;
+}
+
+// slab test of the segment start + (end - start) * t for t in [0, 1]
+static bool segmentHitsBox(const AABB& box, const QVector3D& start, const QVector3D& dir)
+{
+    auto boxMin = box.getMin();
+    auto boxMax = box.getMax();
+
+    float tMin = 0.0f;
+    float tMax = 1.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        if (dir[axis] == 0.0f) {
+            if (start[axis] < boxMin[axis] || start[axis] > boxMax[axis])
+                return false;
+            continue;
+        }
+
+        float invDir = 1.0f / dir[axis];
+        float t1 = (boxMin[axis] - start[axis]) * invDir;
+        float t2 = (boxMax[axis] - start[axis]) * invDir;
+        if (t1 > t2)
+            std::swap(t1, t2);
+
+        tMin = qMax(tMin, t1);
+        tMax = qMin(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+
+    return true;
+}
+
+DynamicAABBTree::DynamicAABBTree()
+{
+    root = DYNAMIC_AABB_TREE_NULL_NODE;
+    freeList = DYNAMIC_AABB_TREE_NULL_NODE;
+    proxyCount = 0;
+}
+
+int DynamicAABBTree::allocateNode()
+{
+    int index;
+    if (freeList != DYNAMIC_AABB_TREE_NULL_NODE) {
+        index = freeList;
+        freeList = nodes[index].parent;
+    } else {
+        index = nodes.size();
+        nodes.append(DynamicAABBTreeNode());
+    }
+
+    auto& node = nodes[index];
+    node.bounds.setNegativeInfinity();
+    node.userData = nullptr;
+    node.parent = DYNAMIC_AABB_TREE_NULL_NODE;
+    node.child1 = DYNAMIC_AABB_TREE_NULL_NODE;
+    node.child2 = DYNAMIC_AABB_TREE_NULL_NODE;
+    node.height = 0;
+
+    return index;
+}
+
+void DynamicAABBTree::freeNode(int node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int DynamicAABBTree::createProxy(const AABB& bounds, void* userData)
+{
+    int proxy = allocateNode();
+    nodes[proxy].bounds = fatten(bounds);
+    nodes[proxy].userData = userData;
+
+    insertLeaf(proxy);
+    proxyCount++;
+
+    return proxy;
+}
+
+void DynamicAABBTree::destroyProxy(int proxy)
+{
+    Q_ASSERT(nodes[proxy].isLeaf());
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicAABBTree::moveProxy(int proxy, const AABB& bounds)
+{
+    Q_ASSERT(nodes[proxy].isLeaf());
+
+    if (contains(nodes[proxy].bounds, bounds))
+        return false;
+
+    removeLeaf(proxy);
+    nodes[proxy].bounds = fatten(bounds);
+    insertLeaf(proxy);
+
+    return true;
+}
+
+void DynamicAABBTree::insertLeaf(int leaf)
+{
+    if (root == DYNAMIC_AABB_TREE_NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = DYNAMIC_AABB_TREE_NULL_NODE;
+        return;
+    }
+
+    // descend towards the sibling that increases the total surface area the least
+    AABB leafBounds = nodes[leaf].bounds;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        const auto& node = nodes[index];
+        int child1 = node.child1;
+        int child2 = node.child2;
+
+        float area = surfaceArea(node.bounds);
+        float combinedArea = surfaceArea(combine(node.bounds, leafBounds));
+
+        // cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+
+        // minimum cost of pushing the leaf further down the tree
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            const auto& childNode = nodes[child];
+            float childArea = surfaceArea(combine(leafBounds, childNode.bounds));
+            if (childNode.isLeaf())
+                return childArea + inheritanceCost;
+            return childArea - surfaceArea(childNode.bounds) + inheritanceCost;
+        };
+
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+
+    // nodes can be reallocated here so no references are held across it
+    int newParent = allocateNode();
+    int oldParent = nodes[sibling].parent;
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].bounds = combine(leafBounds, nodes[sibling].bounds);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != DYNAMIC_AABB_TREE_NULL_NODE) {
+        if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+    } else {
+        root = newParent;
+    }
+
+    // refit and rebalance the ancestors
+    index = nodes[leaf].parent;
+    while (index != DYNAMIC_AABB_TREE_NULL_NODE) {
+        index = balance(index);
+
+        auto& node = nodes[index];
+        node.height = 1 + qMax(nodes[node.child1].height, nodes[node.child2].height);
+        node.bounds = combine(nodes[node.child1].bounds, nodes[node.child2].bounds);
+
+        index = node.parent;
+    }
+}
+
+void DynamicAABBTree::removeLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = DYNAMIC_AABB_TREE_NULL_NODE;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == DYNAMIC_AABB_TREE_NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = DYNAMIC_AABB_TREE_NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    // the sibling takes the parent's place
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    int index = grandParent;
+    while (index != DYNAMIC_AABB_TREE_NULL_NODE) {
+        index = balance(index);
+
+        auto& node = nodes[index];
+        node.bounds = combine(nodes[node.child1].bounds, nodes[node.child2].bounds);
+        node.height = 1 + qMax(nodes[node.child1].height, nodes[node.child2].height);
+
+        index = node.parent;
+    }
+}
+
+// Rotates the taller grandchild up if a's subtrees differ in height by more than one
+// Returns the index of the node now in a's place
+int DynamicAABBTree::balance(int iA)
+{
+    auto& a = nodes[iA];
+    if (a.isLeaf() || a.height < 2)
+        return iA;
+
+    int iB = a.child1;
+    int iC = a.child2;
+    auto& b = nodes[iB];
+    auto& c = nodes[iC];
+
+    int diff = c.height - b.height;
+
+    // rotate c up
+    if (diff > 1) {
+        int iF = c.child1;
+        int iG = c.child2;
+        auto& f = nodes[iF];
+        auto& g = nodes[iG];
+
+        c.child1 = iA;
+        c.parent = a.parent;
+        a.parent = iC;
+
+        if (c.parent != DYNAMIC_AABB_TREE_NULL_NODE) {
+            if (nodes[c.parent].child1 == iA)
+                nodes[c.parent].child1 = iC;
+            else
+                nodes[c.parent].child2 = iC;
+        } else {
+            root = iC;
+        }
+
+        if (f.height > g.height) {
+            c.child2 = iF;
+            a.child2 = iG;
+            g.parent = iA;
+            a.bounds = combine(b.bounds, g.bounds);
+            c.bounds = combine(a.bounds, f.bounds);
+            a.height = 1 + qMax(b.height, g.height);
+            c.height = 1 + qMax(a.height, f.height);
+        } else {
+            c.child2 = iG;
+            a.child2 = iF;
+            f.parent = iA;
+            a.bounds = combine(b.bounds, f.bounds);
+            c.bounds = combine(a.bounds, g.bounds);
+            a.height = 1 + qMax(b.height, f.height);
+            c.height = 1 + qMax(a.height, g.height);
+        }
+
+        return iC;
+    }
+
+    // rotate b up
+    if (diff < -1) {
+        int iD = b.child1;
+        int iE = b.child2;
+        auto& d = nodes[iD];
+        auto& e = nodes[iE];
+
+        b.child1 = iA;
+        b.parent = a.parent;
+        a.parent = iB;
+
+        if (b.parent != DYNAMIC_AABB_TREE_NULL_NODE) {
+            if (nodes[b.parent].child1 == iA)
+                nodes[b.parent].child1 = iB;
+            else
+                nodes[b.parent].child2 = iB;
+        } else {
+            root = iB;
+        }
+
+        if (d.height > e.height) {
+            b.child2 = iD;
+            a.child1 = iE;
+            e.parent = iA;
+            a.bounds = combine(c.bounds, e.bounds);
+            b.bounds = combine(a.bounds, d.bounds);
+            a.height = 1 + qMax(c.height, e.height);
+            b.height = 1 + qMax(a.height, d.height);
+        } else {
+            b.child2 = iE;
+            a.child1 = iD;
+            d.parent = iA;
+            a.bounds = combine(c.bounds, d.bounds);
+            b.bounds = combine(a.bounds, e.bounds);
+            a.height = 1 + qMax(c.height, d.height);
+            b.height = 1 + qMax(a.height, e.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+void DynamicAABBTree::querySegment(const QVector3D& segmentStart, const QVector3D& segmentEnd, QVector<void*>& hits) const
+{
+    if (root == DYNAMIC_AABB_TREE_NULL_NODE)
+        return;
+
+    auto dir = segmentEnd - segmentStart;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(root);
+    while (!stack.isEmpty()) {
+        int index = stack.last();
+        stack.removeLast();
+
+        const auto& node = nodes[index];
+        if (!segmentHitsBox(node.bounds, segmentStart, dir))
+            continue;
+
+        if (node.isLeaf()) {
+            hits.append(node.userData);
+        } else {
+            stack.append(node.child1);
+            stack.append(node.child2);
+        }
+    }
+}
+
+}
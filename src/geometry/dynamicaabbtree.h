@@ -0,0 +1,96 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include <QVector>
+#include <QVector3D>
+
+#include "aabb.h"
+
+#define DYNAMIC_AABB_TREE_NULL_NODE -1
+
+namespace iris
+{
+
+struct DynamicAABBTreeNode
+{
+    AABB bounds;
+    void* userData;
+
+    // doubles as the next free node while the node is on the free list
+    int parent;
+    int child1;
+    int child2;
+
+    // leaves are 0, free nodes -1
+    int height;
+
+    bool isLeaf() const
+    {
+        return child1 == DYNAMIC_AABB_TREE_NULL_NODE;
+    }
+};
+
+/**
+ * Incrementally updated bounding volume tree for moving objects.
+ * Each proxy is stored with an enlarged ("fat") box so small movements don't
+ * touch the tree, larger ones remove and reinsert just that leaf. The tree is
+ * kept balanced with rotations on the way back up from inserts and removals.
+ */
+class DynamicAABBTree
+{
+public:
+    DynamicAABBTree();
+
+    // returns the proxy id used to move or destroy the proxy
+    int createProxy(const AABB& bounds, void* userData);
+    void destroyProxy(int proxy);
+
+    // returns true if the proxy had to be reinserted
+    bool moveProxy(int proxy, const AABB& bounds);
+
+    void* getUserData(int proxy) const
+    {
+        return nodes[proxy].userData;
+    }
+
+    const AABB& getFatBounds(int proxy) const
+    {
+        return nodes[proxy].bounds;
+    }
+
+    int getProxyCount() const
+    {
+        return proxyCount;
+    }
+
+    // appends the user data of every proxy whose fat box the segment passes through
+    void querySegment(const QVector3D& segmentStart, const QVector3D& segmentEnd, QVector<void*>& hits) const;
+
+private:
+    int allocateNode();
+    void freeNode(int node);
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    int balance(int node);
+
+    QVector<DynamicAABBTreeNode> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+};
+
+}
+
+#endif // DYNAMICAABBTREE_H
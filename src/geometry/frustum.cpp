@@ -1,6 +1,7 @@
 #include "frustum.h"
 #include "plane.h"
 #include "boundingsphere.h"
+#include "aabb.h"
 #include <QMatrix4x4>
 
 namespace iris {
@@ -46,6 +47,33 @@ bool Frustum::isSphereInside(BoundingSphere *sphere)
     return true;
 }
 
+// tests the box's corners that are furthest along and against each plane's normal
+// http://www.lighthouse3d.com/tutorials/view-frustum-culling/geometric-approach-testing-boxes-ii/
+FrustumClassification Frustum::classifyAABB(const AABB& aabb)
+{
+    auto min = aabb.getMin();
+    auto max = aabb.getMax();
+    auto result = FrustumClassification::Inside;
+
+    for(auto& plane : planes) {
+        auto& n = plane.normal;
+
+        QVector3D positive(n.x() >= 0 ? max.x() : min.x(),
+                           n.y() >= 0 ? max.y() : min.y(),
+                           n.z() >= 0 ? max.z() : min.z());
+        if (QVector3D::dotProduct(n, positive) + plane.d < 0)
+            return FrustumClassification::Outside;
+
+        QVector3D negative(n.x() >= 0 ? min.x() : max.x(),
+                           n.y() >= 0 ? min.y() : max.y(),
+                           n.z() >= 0 ? min.z() : max.z());
+        if (QVector3D::dotProduct(n, negative) + plane.d < 0)
+            result = FrustumClassification::Intersects;
+    }
+
+    return result;
+}
+
 
 
 }
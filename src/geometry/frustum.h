@@ -8,6 +8,15 @@
 namespace iris {
 
 class BoundingSphere;
+class AABB;
+
+enum class FrustumClassification
+{
+    Outside,
+    Intersects,
+    Inside
+};
+
 class Frustum
 {
 public:
@@ -18,6 +27,10 @@ public:
 
     // checks if the sphere is inside or touches the bounding sphere
     bool isSphereInside(BoundingSphere* sphere);
+
+    // tells whether the box is completely outside, partially inside or completely inside
+    // the frustum. Inside results let hierarchical culling skip testing the children
+    FrustumClassification classifyAABB(const AABB& aabb);
 };
 
 }
@@ -0,0 +1,310 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "trianglekernel.h"
+#include "trimesh.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIANGLE_KERNEL_SSE
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TRIANGLE_KERNEL_AVX_TARGET
+#else
+#define TRIANGLE_KERNEL_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+/*
+ * Every kernel does the same float operations in the same order as
+ * TriMesh::intersectSegment, vectorized across triangles instead of within
+ * one, so the hits and t values are bit-identical whichever one runs.
+ * The rejection tests are written as ordered comparisons that are false
+ * for NaN to match the scalar early outs
+ */
+
+namespace iris
+{
+
+void TriangleSoA::build(const QList<Triangle>& triangles, const QVector<int>& order)
+{
+    count = order.size();
+
+    // zeroed padding has a zero normal which every kernel rejects
+    int size = count + TRIANGLE_SOA_PADDING;
+    for (auto array : {&ax, &ay, &az, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z, &nx, &ny, &nz})
+        array->fill(0.0f, size);
+
+    for (int i = 0; i < count; i++) {
+        const Triangle& tri = triangles[order[i]];
+        auto ab = tri.b - tri.a;
+        auto ac = tri.c - tri.a;
+        auto normal = QVector3D::crossProduct(ab, ac);
+
+        ax[i] = tri.a.x();
+        ay[i] = tri.a.y();
+        az[i] = tri.a.z();
+        e1x[i] = ab.x();
+        e1y[i] = ab.y();
+        e1z[i] = ab.z();
+        e2x[i] = ac.x();
+        e2y[i] = ac.y();
+        e2z[i] = ac.z();
+        nx[i] = normal.x();
+        ny[i] = normal.y();
+        nz[i] = normal.z();
+    }
+}
+
+static int segmentTrianglesScalar(const TriangleSoA& tris,
+                                  int begin,
+                                  int count,
+                                  const QVector3D& segmentStart,
+                                  const QVector3D& segmentEnd,
+                                  int* hitSlots,
+                                  float* hitTs)
+{
+    const float qpx = segmentStart.x() - segmentEnd.x();
+    const float qpy = segmentStart.y() - segmentEnd.y();
+    const float qpz = segmentStart.z() - segmentEnd.z();
+    const float sx = segmentStart.x();
+    const float sy = segmentStart.y();
+    const float sz = segmentStart.z();
+
+    int hits = 0;
+    for (int i = begin; i < begin + count; i++) {
+        float d = qpx * tris.nx[i] + qpy * tris.ny[i] + qpz * tris.nz[i];
+        if (d <= 0)
+            continue;
+
+        float apx = sx - tris.ax[i];
+        float apy = sy - tris.ay[i];
+        float apz = sz - tris.az[i];
+        float t = apx * tris.nx[i] + apy * tris.ny[i] + apz * tris.nz[i];
+        if (t < 0 || t > d)
+            continue;
+
+        float ex = qpy * apz - qpz * apy;
+        float ey = qpz * apx - qpx * apz;
+        float ez = qpx * apy - qpy * apx;
+
+        float v = tris.e2x[i] * ex + tris.e2y[i] * ey + tris.e2z[i] * ez;
+        if (v < 0 || v > d)
+            continue;
+
+        float w = -(tris.e1x[i] * ex + tris.e1y[i] * ey + tris.e1z[i] * ez);
+        if (w < 0.0f || v + w > d)
+            continue;
+
+        hitSlots[hits] = i;
+        hitTs[hits] = t / d;
+        hits++;
+    }
+
+    return hits;
+}
+
+#ifdef TRIANGLE_KERNEL_SSE
+
+static int segmentTrianglesSSE(const TriangleSoA& tris,
+                               int begin,
+                               int count,
+                               const QVector3D& segmentStart,
+                               const QVector3D& segmentEnd,
+                               int* hitSlots,
+                               float* hitTs)
+{
+    const __m128 qpx = _mm_set1_ps(segmentStart.x() - segmentEnd.x());
+    const __m128 qpy = _mm_set1_ps(segmentStart.y() - segmentEnd.y());
+    const __m128 qpz = _mm_set1_ps(segmentStart.z() - segmentEnd.z());
+    const __m128 sx = _mm_set1_ps(segmentStart.x());
+    const __m128 sy = _mm_set1_ps(segmentStart.y());
+    const __m128 sz = _mm_set1_ps(segmentStart.z());
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    int hits = 0;
+    int end = begin + count;
+    for (int i = begin; i < end; i += 4) {
+        __m128 nx = _mm_loadu_ps(tris.nx.constData() + i);
+        __m128 ny = _mm_loadu_ps(tris.ny.constData() + i);
+        __m128 nz = _mm_loadu_ps(tris.nz.constData() + i);
+
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qpx, nx), _mm_mul_ps(qpy, ny)), _mm_mul_ps(qpz, nz));
+
+        __m128 apx = _mm_sub_ps(sx, _mm_loadu_ps(tris.ax.constData() + i));
+        __m128 apy = _mm_sub_ps(sy, _mm_loadu_ps(tris.ay.constData() + i));
+        __m128 apz = _mm_sub_ps(sz, _mm_loadu_ps(tris.az.constData() + i));
+        __m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(apx, nx), _mm_mul_ps(apy, ny)), _mm_mul_ps(apz, nz));
+
+        __m128 ex = _mm_sub_ps(_mm_mul_ps(qpy, apz), _mm_mul_ps(qpz, apy));
+        __m128 ey = _mm_sub_ps(_mm_mul_ps(qpz, apx), _mm_mul_ps(qpx, apz));
+        __m128 ez = _mm_sub_ps(_mm_mul_ps(qpx, apy), _mm_mul_ps(qpy, apx));
+
+        __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(tris.e2x.constData() + i), ex),
+                                         _mm_mul_ps(_mm_loadu_ps(tris.e2y.constData() + i), ey)),
+                              _mm_mul_ps(_mm_loadu_ps(tris.e2z.constData() + i), ez));
+        __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(tris.e1x.constData() + i), ex),
+                                         _mm_mul_ps(_mm_loadu_ps(tris.e1y.constData() + i), ey)),
+                              _mm_mul_ps(_mm_loadu_ps(tris.e1z.constData() + i), ez));
+        w = _mm_xor_ps(w, signBit);
+
+        __m128 reject = _mm_cmple_ps(d, zero);
+        reject = _mm_or_ps(reject, _mm_cmplt_ps(t, zero));
+        reject = _mm_or_ps(reject, _mm_cmpgt_ps(t, d));
+        reject = _mm_or_ps(reject, _mm_cmplt_ps(v, zero));
+        reject = _mm_or_ps(reject, _mm_cmpgt_ps(v, d));
+        reject = _mm_or_ps(reject, _mm_cmplt_ps(w, zero));
+        reject = _mm_or_ps(reject, _mm_cmpgt_ps(_mm_add_ps(v, w), d));
+
+        int mask = ~_mm_movemask_ps(reject) & 0xF;
+        if (end - i < 4)
+            mask &= (1 << (end - i)) - 1;
+
+        if (mask) {
+            float ts[4];
+            _mm_storeu_ps(ts, _mm_div_ps(t, d));
+            for (int lane = 0; lane < 4; lane++) {
+                if (mask & (1 << lane)) {
+                    hitSlots[hits] = i + lane;
+                    hitTs[hits] = ts[lane];
+                    hits++;
+                }
+            }
+        }
+    }
+
+    return hits;
+}
+
+TRIANGLE_KERNEL_AVX_TARGET
+static int segmentTrianglesAVX(const TriangleSoA& tris,
+                               int begin,
+                               int count,
+                               const QVector3D& segmentStart,
+                               const QVector3D& segmentEnd,
+                               int* hitSlots,
+                               float* hitTs)
+{
+    const __m256 qpx = _mm256_set1_ps(segmentStart.x() - segmentEnd.x());
+    const __m256 qpy = _mm256_set1_ps(segmentStart.y() - segmentEnd.y());
+    const __m256 qpz = _mm256_set1_ps(segmentStart.z() - segmentEnd.z());
+    const __m256 sx = _mm256_set1_ps(segmentStart.x());
+    const __m256 sy = _mm256_set1_ps(segmentStart.y());
+    const __m256 sz = _mm256_set1_ps(segmentStart.z());
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+
+    int hits = 0;
+    int end = begin + count;
+    for (int i = begin; i < end; i += 8) {
+        __m256 nx = _mm256_loadu_ps(tris.nx.constData() + i);
+        __m256 ny = _mm256_loadu_ps(tris.ny.constData() + i);
+        __m256 nz = _mm256_loadu_ps(tris.nz.constData() + i);
+
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qpx, nx), _mm256_mul_ps(qpy, ny)), _mm256_mul_ps(qpz, nz));
+
+        __m256 apx = _mm256_sub_ps(sx, _mm256_loadu_ps(tris.ax.constData() + i));
+        __m256 apy = _mm256_sub_ps(sy, _mm256_loadu_ps(tris.ay.constData() + i));
+        __m256 apz = _mm256_sub_ps(sz, _mm256_loadu_ps(tris.az.constData() + i));
+        __m256 t = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(apx, nx), _mm256_mul_ps(apy, ny)), _mm256_mul_ps(apz, nz));
+
+        __m256 ex = _mm256_sub_ps(_mm256_mul_ps(qpy, apz), _mm256_mul_ps(qpz, apy));
+        __m256 ey = _mm256_sub_ps(_mm256_mul_ps(qpz, apx), _mm256_mul_ps(qpx, apz));
+        __m256 ez = _mm256_sub_ps(_mm256_mul_ps(qpx, apy), _mm256_mul_ps(qpy, apx));
+
+        __m256 v = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(tris.e2x.constData() + i), ex),
+                                               _mm256_mul_ps(_mm256_loadu_ps(tris.e2y.constData() + i), ey)),
+                                 _mm256_mul_ps(_mm256_loadu_ps(tris.e2z.constData() + i), ez));
+        __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(tris.e1x.constData() + i), ex),
+                                               _mm256_mul_ps(_mm256_loadu_ps(tris.e1y.constData() + i), ey)),
+                                 _mm256_mul_ps(_mm256_loadu_ps(tris.e1z.constData() + i), ez));
+        w = _mm256_xor_ps(w, signBit);
+
+        __m256 reject = _mm256_cmp_ps(d, zero, _CMP_LE_OQ);
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(t, zero, _CMP_LT_OQ));
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(t, d, _CMP_GT_OQ));
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(v, zero, _CMP_LT_OQ));
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(v, d, _CMP_GT_OQ));
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(w, zero, _CMP_LT_OQ));
+        reject = _mm256_or_ps(reject, _mm256_cmp_ps(_mm256_add_ps(v, w), d, _CMP_GT_OQ));
+
+        int mask = ~_mm256_movemask_ps(reject) & 0xFF;
+        if (end - i < 8)
+            mask &= (1 << (end - i)) - 1;
+
+        if (mask) {
+            float ts[8];
+            _mm256_storeu_ps(ts, _mm256_div_ps(t, d));
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) {
+                    hitSlots[hits] = i + lane;
+                    hitTs[hits] = ts[lane];
+                    hits++;
+                }
+            }
+        }
+    }
+
+    return hits;
+}
+
+static bool cpuSupportsAvx()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+    bool cpuHasAvx = (info[2] & (1 << 28)) != 0;
+    if (!osUsesXSave || !cpuHasAvx)
+        return false;
+
+    // the os has to save the ymm registers on context switches
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+#endif
+
+TriangleKernelType getBestTriangleKernelType()
+{
+#ifdef TRIANGLE_KERNEL_SSE
+    static TriangleKernelType type = cpuSupportsAvx() ? TriangleKernelType::AVX : TriangleKernelType::SSE;
+    return type;
+#else
+    return TriangleKernelType::Scalar;
+#endif
+}
+
+SegmentTriangleKernel getSegmentTriangleKernel(TriangleKernelType type)
+{
+    switch (type) {
+#ifdef TRIANGLE_KERNEL_SSE
+    case TriangleKernelType::SSE:
+        return segmentTrianglesSSE;
+    case TriangleKernelType::AVX:
+        return cpuSupportsAvx() ? segmentTrianglesAVX : segmentTrianglesSSE;
+#endif
+    default:
+        return segmentTrianglesScalar;
+    }
+}
+
+SegmentTriangleKernel getSegmentTriangleKernel()
+{
+    static SegmentTriangleKernel kernel = getSegmentTriangleKernel(getBestTriangleKernelType());
+    return kernel;
+}
+
+}
@@ -0,0 +1,72 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TRIANGLEKERNEL_H
+#define TRIANGLEKERNEL_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QList>
+
+// arrays are padded so kernels can always load this many triangles at once
+#define TRIANGLE_SOA_PADDING 8
+
+namespace iris
+{
+
+class Triangle;
+
+/**
+ * Triangles split into one array per component so several can be tested at
+ * once. The edges and normal are precomputed exactly as TriMesh::intersectSegment
+ * computes them so every kernel gives the same hits
+ */
+struct TriangleSoA
+{
+    QVector<float> ax, ay, az;
+    QVector<float> e1x, e1y, e1z;
+    QVector<float> e2x, e2y, e2z;
+    QVector<float> nx, ny, nz;
+
+    int count = 0;
+
+    // stores triangles[order[i]] in slot i
+    void build(const QList<Triangle>& triangles, const QVector<int>& order);
+};
+
+enum class TriangleKernelType
+{
+    Scalar,
+    SSE,
+    AVX
+};
+
+/*
+ * Segment test against slots [begin, begin + count)
+ * Writes the slot and t of each hit in slot order and returns the number of hits,
+ * hitSlots and hitTs need room for count entries
+ */
+typedef int (*SegmentTriangleKernel)(const TriangleSoA& tris,
+                                     int begin,
+                                     int count,
+                                     const QVector3D& segmentStart,
+                                     const QVector3D& segmentEnd,
+                                     int* hitSlots,
+                                     float* hitTs);
+
+// widest kernel the cpu supports, picked once on first use
+SegmentTriangleKernel getSegmentTriangleKernel();
+SegmentTriangleKernel getSegmentTriangleKernel(TriangleKernelType type);
+TriangleKernelType getBestTriangleKernelType();
+
+}
+
+#endif // TRIANGLEKERNEL_H
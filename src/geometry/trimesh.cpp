@@ -10,10 +10,21 @@ For more information see the LICENSE file
 *************************************************************************/
 
 #include "trimesh.h"
+#include "trimeshbvh.h"
 
 namespace iris
 {
 
+TriMesh::TriMesh()
+{
+    bvh = nullptr;
+}
+
+TriMesh::~TriMesh()
+{
+    delete bvh;
+}
+
 /**
  * Adds points for triangle. Assumes points are in a counter-clockwise rotation.
  * @param a
@@ -25,55 +36,112 @@ void TriMesh::addTriangle(const QVector3D& a,const QVector3D& b,const QVector3D&
     Triangle tri = {a,b,c,QVector3D::crossProduct(b-a,c-a)};
 
     triangles.append(tri);
+
+    // rebuilt on the next query
+    delete bvh;
+    bvh = nullptr;
+}
+
+void TriMesh::clear()
+{
+    triangles.clear();
+
+    delete bvh;
+    bvh = nullptr;
+}
+
+TriMeshBVH* TriMesh::getBVH()
+{
+    if (bvh == nullptr)
+        bvh = TriMeshBVH::build(triangles);
+
+    return bvh;
 }
 
 //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
 //realtime rendering page 192
-//no need to get uvw, just return true at the first sign of a hit
-bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+//no need to get uvw, t is in range 0 and 1 and denotes how far along the segment the hit is
+bool TriMesh::intersectSegment(const Triangle& tri, const QVector3D& segmentStart, const QVector3D& segmentEnd, float& t)
 {
-    for(auto tri:triangles)
-    {
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
+    auto ab = tri.b - tri.a;
+    auto ac = tri.c - tri.a;
+    auto qp = segmentStart-segmentEnd;
 
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
+    //auto normal = tri.normal;
+    auto normal = QVector3D::crossProduct(ab, ac);
+    float d = QVector3D::dotProduct(qp, normal);
 
-        //if (d <= 0)
-        //    continue;
-        if (d == 0) continue;
+    // back facing or parallel
+    if (d <= 0)
+        return false;
 
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
+    auto ap = segmentStart - tri.a;
+    t = QVector3D::dotProduct(ap, normal);
 
-        if (t < 0 || t > d)
-            continue;
+    if (t < 0 || t > d)
+        return false;
 
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
+    auto e = QVector3D::crossProduct(qp, ap);
+    auto v = QVector3D::dotProduct(ac, e);
 
-        if (v < 0.0f || v > d)
-            continue;
+    if (v < 0 || v > d)
+        return false;
 
-        auto w = -QVector3D::dotProduct(ab, e);
+    auto w = -QVector3D::dotProduct(ab, e);
 
-        if (w < 0.0f || v + w > d)
-            continue;
+    if (w < 0.0f || v + w > d)
+        return false;
+
+    t /= d;
+
+    //all conditions have been met
+    return true;
+}
+
+bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segmentEnd,QVector3D& hitPoint)
+{
+    if (triangles.size() >= TRIMESH_BVH_MIN_TRIANGLES) {
+        TriangleIntersectionResult result;
+        if (getBVH()->isHitBySegment(segmentStart, segmentEnd, result)) {
+            hitPoint = result.hitPoint;
+            return true;
+        }
 
-        t /= d;
+        return false;
+    }
 
-        //all conditions have been met
-        //todo: fix please. return t instead
-        hitPoint = segmentStart + (segmentEnd-segmentStart)*t;//t is in range 0 and 1 and denotes how far along the distance the hit is
-        return true;
+    for(const auto& tri:triangles)
+    {
+        float t;
+        if (intersectSegment(tri, segmentStart, segmentEnd, t)) {
+            hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
+            return true;
+        }
     }
 
     return false;
 }
 
+bool TriMesh::getClosestSegmentIntersection(const QVector3D& segmentStart, const QVector3D& segmentEnd, TriangleIntersectionResult& result)
+{
+    if (triangles.size() >= TRIMESH_BVH_MIN_TRIANGLES)
+        return getBVH()->getClosestIntersection(segmentStart, segmentEnd, result);
+
+    bool hit = false;
+    for(auto i=0;i<triangles.size();i++)
+    {
+        float t;
+        if (intersectSegment(triangles[i], segmentStart, segmentEnd, t) && (!hit || t < result.t)) {
+            result.triangleIndex = i;
+            result.hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
+            result.t = t;
+            hit = true;
+        }
+    }
+
+    return hit;
+}
+
 /**
  * Does a segment-mesh intersection test
  * Returns number of intersections
@@ -81,57 +149,27 @@ bool TriMesh::isHitBySegment(const QVector3D& segmentStart,const QVector3D& segm
  */
 int TriMesh::getSegmentIntersections(const QVector3D& segmentStart,const QVector3D& segmentEnd,QList<TriangleIntersectionResult>& results)
 {
-    int hits = 0;
-    for(auto i=0;i<triangles.size();i++)
-    {
-        //auto tri = triangles[i];
-        const Triangle& tri = triangles[i];
-        auto ab = tri.b - tri.a;
-        auto ac = tri.c - tri.a;
-        auto qp = segmentStart-segmentEnd;
-
-        //auto normal = tri.normal;
-        auto normal = QVector3D::crossProduct(ab, ac);
-        float d = QVector3D::dotProduct(qp, normal);
+    int initialCount = results.size();
 
-        if (d <= 0)
-            continue;
-
-        auto ap = segmentStart - tri.a;
-        auto t = QVector3D::dotProduct(ap, normal);
-
-        if (t < 0 || t > d)
-            continue;
-
-        auto e = QVector3D::crossProduct(qp, ap);
-        auto v = QVector3D::dotProduct(ac, e);
-
-        if (v < 0 || v > d)
-            continue;
-
-        auto w = -QVector3D::dotProduct(ab, e);
+    if (triangles.size() >= TRIMESH_BVH_MIN_TRIANGLES) {
+        getBVH()->getSegmentIntersections(segmentStart, segmentEnd, results);
+        return results.size() - initialCount;
+    }
 
-        if (w < 0.0f || v + w > d)
+    for(auto i=0;i<triangles.size();i++)
+    {
+        float t;
+        if (!intersectSegment(triangles[i], segmentStart, segmentEnd, t))
             continue;
 
-        t /= d;
-
-        //all conditions have been met
-        hits++;
-
-        auto dist = segmentStart.distanceToPoint(segmentEnd);
-        auto hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
-
         TriangleIntersectionResult result;
         result.triangleIndex = i;
-        result.hitPoint = hitPoint;
+        result.hitPoint = segmentStart + (segmentEnd-segmentStart)*t;
         result.t = t;
-        //result.hitPoint = tri.a*u + tri.b*v + tri.c*w;
         results.append(result);
-        hits++;
     }
 
-    return hits;
+    return results.size() - initialCount;
 }
 
 }
@@ -15,9 +15,14 @@ For more information see the LICENSE file
 #include <QVector3D>
 #include <QList>
 
+// smaller meshes are cheaper to test triangle by triangle than to build a bvh for
+#define TRIMESH_BVH_MIN_TRIANGLES 64
+
 namespace iris
 {
 
+class TriMeshBVH;
+
 struct TriangleIntersectionResult
 {
     int triangleIndex;
@@ -44,9 +49,23 @@ public:
  */
 class TriMesh
 {
+    TriMeshBVH* bvh;
+
 public:
+    // triangles should only be added through addTriangle so the bvh gets rebuilt
     QList<Triangle> triangles;
 
+    TriMesh();
+    ~TriMesh();
+
+    // built on first use
+    TriMeshBVH* getBVH();
+
+    /**
+     * Segment-triangle test shared by all queries, back facing triangles are ignored
+     * t is set to how far along the segment the hit is, from 0 to 1
+     */
+    static bool intersectSegment(const Triangle& tri, const QVector3D& segmentStart, const QVector3D& segmentEnd, float& t);
 
     /**
      * Adds points for triangle. Assumes points are in a counter-clockwise rotation.
@@ -56,9 +75,10 @@ public:
      */
     void addTriangle(const QVector3D& a, const QVector3D& b, const QVector3D& c);
 
-    //https://github.com/qt/qt3d/blob/5476bc6b4b6a12c921da502c24c4e078b04dd3b3/src/render/jobs/pickboundingvolumejob.cpp
-    //realtime rendering page 192
-    //no need to get uvw, just return true at the first sign of a hit
+    // removes every triangle
+    void clear();
+
+    //just return true at the first sign of a hit, not necessarily the closest one
     bool isHitBySegment(const QVector3D& segmentStart, const QVector3D& segmentEnd, QVector3D& hitPoint);
 
     /**
@@ -68,6 +88,11 @@ public:
      */
     int getSegmentIntersections(const QVector3D& segmentStart, const QVector3D& segmentEnd, QList<TriangleIntersectionResult>& results);
 
+    /**
+     * Finds the hit nearest to segmentStart
+     * Returns false if the segment misses the mesh
+     */
+    bool getClosestSegmentIntersection(const QVector3D& segmentStart, const QVector3D& segmentEnd, TriangleIntersectionResult& result);
 
 };
 
@@ -0,0 +1,413 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "trimeshbvh.h"
+#include "trimesh.h"
+
+#include <QVarLengthArray>
+#include <algorithm>
+#include <limits>
+
+#define BVH_BIN_COUNT 12
+#define BVH_MAX_LEAF_SIZE 8
+
+namespace iris
+{
+
+static float surfaceArea(const QVector3D& boundsMin, const QVector3D& boundsMax)
+{
+    auto size = boundsMax - boundsMin;
+    return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+}
+
+static QVector3D minVec(const QVector3D& a, const QVector3D& b)
+{
+    return QVector3D(qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMin(a.z(), b.z()));
+}
+
+static QVector3D maxVec(const QVector3D& a, const QVector3D& b)
+{
+    return QVector3D(qMax(a.x(), b.x()), qMax(a.y(), b.y()), qMax(a.z(), b.z()));
+}
+
+// slab test of the segment origin + dir * t for t in [0, tMax]
+static bool segmentHitsNode(const TriMeshBVHNode& node,
+                            const QVector3D& origin,
+                            const QVector3D& dir,
+                            const QVector3D& invDir,
+                            float tMax,
+                            float& tEntry)
+{
+    float tMin = 0.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        if (dir[axis] == 0.0f) {
+            if (origin[axis] < node.boundsMin[axis] || origin[axis] > node.boundsMax[axis])
+                return false;
+            continue;
+        }
+
+        float t1 = (node.boundsMin[axis] - origin[axis]) * invDir[axis];
+        float t2 = (node.boundsMax[axis] - origin[axis]) * invDir[axis];
+        if (t1 > t2)
+            std::swap(t1, t2);
+
+        tMin = qMax(tMin, t1);
+        tMax = qMin(tMax, t2);
+        if (tMin > tMax)
+            return false;
+    }
+
+    tEntry = tMin;
+    return true;
+}
+
+static QVector3D inverseDirection(const QVector3D& dir)
+{
+    return QVector3D(dir.x() != 0.0f ? 1.0f / dir.x() : 0.0f,
+                     dir.y() != 0.0f ? 1.0f / dir.y() : 0.0f,
+                     dir.z() != 0.0f ? 1.0f / dir.z() : 0.0f);
+}
+
+TriMeshBVH* TriMeshBVH::build(const QList<Triangle>& triangles)
+{
+    auto bvh = new TriMeshBVH();
+
+    int count = triangles.size();
+    bvh->triIndices.resize(count);
+    bvh->triMins.resize(count);
+    bvh->triMaxs.resize(count);
+    bvh->centroids.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        const Triangle& tri = triangles[i];
+        bvh->triIndices[i] = i;
+        bvh->triMins[i] = minVec(tri.a, minVec(tri.b, tri.c));
+        bvh->triMaxs[i] = maxVec(tri.a, maxVec(tri.b, tri.c));
+        bvh->centroids[i] = (bvh->triMins[i] + bvh->triMaxs[i]) * 0.5f;
+    }
+
+    if (count > 0) {
+        bvh->nodes.reserve(count * 2);
+        bvh->buildNode(0, count);
+    }
+
+    bvh->leafTriangles.build(triangles, bvh->triIndices);
+
+    bvh->triMins.clear();
+    bvh->triMaxs.clear();
+    bvh->centroids.clear();
+    bvh->nodes.squeeze();
+
+    return bvh;
+}
+
+int TriMeshBVH::buildNode(int start, int count)
+{
+    int index = nodes.size();
+    nodes.append(TriMeshBVHNode());
+
+    const float maxFloat = std::numeric_limits<float>::max();
+    QVector3D boundsMin(maxFloat, maxFloat, maxFloat);
+    QVector3D boundsMax(-maxFloat, -maxFloat, -maxFloat);
+    QVector3D centroidMin = boundsMin;
+    QVector3D centroidMax = boundsMax;
+
+    for (int i = start; i < start + count; i++) {
+        int tri = triIndices[i];
+        boundsMin = minVec(boundsMin, triMins[tri]);
+        boundsMax = maxVec(boundsMax, triMaxs[tri]);
+        centroidMin = minVec(centroidMin, centroids[tri]);
+        centroidMax = maxVec(centroidMax, centroids[tri]);
+    }
+
+    // padded so hits rounding onto a face of the box aren't rejected, flat
+    // meshes have a zero sized axis so the padding can't be purely relative
+    auto magnitude = maxVec(QVector3D(qAbs(boundsMin.x()), qAbs(boundsMin.y()), qAbs(boundsMin.z())),
+                            QVector3D(qAbs(boundsMax.x()), qAbs(boundsMax.y()), qAbs(boundsMax.z())));
+    auto pad = (boundsMax - boundsMin) * 1e-4f + magnitude * 1e-6f + QVector3D(1e-6f, 1e-6f, 1e-6f);
+    nodes[index].boundsMin = boundsMin - pad;
+    nodes[index].boundsMax = boundsMax + pad;
+    nodes[index].offset = start;
+    nodes[index].count = count;
+
+    if (count <= 2)
+        return index;
+
+    // find the cheapest binned split over all three axes
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = maxFloat;
+
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = centroidMax[axis] - centroidMin[axis];
+        if (extent <= 0.0f)
+            continue;
+
+        int binCounts[BVH_BIN_COUNT] = {0};
+        QVector3D binMins[BVH_BIN_COUNT];
+        QVector3D binMaxs[BVH_BIN_COUNT];
+        for (int b = 0; b < BVH_BIN_COUNT; b++) {
+            binMins[b] = QVector3D(maxFloat, maxFloat, maxFloat);
+            binMaxs[b] = QVector3D(-maxFloat, -maxFloat, -maxFloat);
+        }
+
+        float scale = BVH_BIN_COUNT / extent;
+        for (int i = start; i < start + count; i++) {
+            int tri = triIndices[i];
+            int b = qMin(BVH_BIN_COUNT - 1, (int)((centroids[tri][axis] - centroidMin[axis]) * scale));
+            binCounts[b]++;
+            binMins[b] = minVec(binMins[b], triMins[tri]);
+            binMaxs[b] = maxVec(binMaxs[b], triMaxs[tri]);
+        }
+
+        // sweep from the right so the left side can be accumulated in the second pass
+        float rightCosts[BVH_BIN_COUNT];
+        QVector3D accumMin(maxFloat, maxFloat, maxFloat);
+        QVector3D accumMax(-maxFloat, -maxFloat, -maxFloat);
+        int accumCount = 0;
+        for (int b = BVH_BIN_COUNT - 1; b > 0; b--) {
+            accumCount += binCounts[b];
+            accumMin = minVec(accumMin, binMins[b]);
+            accumMax = maxVec(accumMax, binMaxs[b]);
+            rightCosts[b] = accumCount > 0 ? accumCount * surfaceArea(accumMin, accumMax) : 0.0f;
+        }
+
+        accumMin = QVector3D(maxFloat, maxFloat, maxFloat);
+        accumMax = QVector3D(-maxFloat, -maxFloat, -maxFloat);
+        accumCount = 0;
+        for (int b = 0; b < BVH_BIN_COUNT - 1; b++) {
+            accumCount += binCounts[b];
+            accumMin = minVec(accumMin, binMins[b]);
+            accumMax = maxVec(accumMax, binMaxs[b]);
+            if (accumCount == 0 || accumCount == count)
+                continue;
+
+            float cost = accumCount * surfaceArea(accumMin, accumMax) + rightCosts[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    // every centroid is in the same spot, nothing left to split
+    if (bestAxis < 0)
+        return index;
+
+    float leafCost = count * surfaceArea(boundsMin, boundsMax);
+    if (bestCost >= leafCost && count <= BVH_MAX_LEAF_SIZE)
+        return index;
+
+    float extent = centroidMax[bestAxis] - centroidMin[bestAxis];
+    float scale = BVH_BIN_COUNT / extent;
+    auto mid = std::partition(triIndices.begin() + start,
+                              triIndices.begin() + start + count,
+                              [&](int tri) {
+        int b = qMin(BVH_BIN_COUNT - 1, (int)((centroids[tri][bestAxis] - centroidMin[bestAxis]) * scale));
+        return b < bestSplit;
+    });
+
+    int leftCount = mid - (triIndices.begin() + start);
+    if (leftCount == 0 || leftCount == count)
+        return index;
+
+    buildNode(start, leftCount);
+    int right = buildNode(start + leftCount, count - leftCount);
+
+    nodes[index].offset = right;
+    nodes[index].count = 0;
+
+    return index;
+}
+
+void TriMeshBVH::getSegmentIntersections(const QVector3D& segmentStart,
+                                         const QVector3D& segmentEnd,
+                                         QList<TriangleIntersectionResult>& results) const
+{
+    if (nodes.isEmpty())
+        return;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDirection(dir);
+
+    auto kernel = getSegmentTriangleKernel();
+    QVarLengthArray<int, BVH_MAX_LEAF_SIZE> hitSlots;
+    QVarLengthArray<float, BVH_MAX_LEAF_SIZE> hitTs;
+
+    QList<TriangleIntersectionResult> hits;
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        stack.removeLast();
+
+        const TriMeshBVHNode& node = nodes[nodeIndex];
+        float tEntry;
+        if (!segmentHitsNode(node, segmentStart, dir, invDir, 1.0f, tEntry))
+            continue;
+
+        if (node.count > 0) {
+            hitSlots.resize(node.count);
+            hitTs.resize(node.count);
+            int hitCount = kernel(leafTriangles, node.offset, node.count, segmentStart, segmentEnd, hitSlots.data(), hitTs.data());
+            for (int i = 0; i < hitCount; i++) {
+                TriangleIntersectionResult result;
+                result.triangleIndex = triIndices[hitSlots[i]];
+                result.hitPoint = segmentStart + dir * hitTs[i];
+                result.t = hitTs[i];
+                hits.append(result);
+            }
+        } else {
+            stack.append(node.offset);
+            stack.append(nodeIndex + 1);
+        }
+    }
+
+    // brute force reports hits in triangle order
+    std::sort(hits.begin(), hits.end(), [](const TriangleIntersectionResult& a, const TriangleIntersectionResult& b) {
+        return a.triangleIndex < b.triangleIndex;
+    });
+
+    results.append(hits);
+}
+
+bool TriMeshBVH::getClosestIntersection(const QVector3D& segmentStart,
+                                        const QVector3D& segmentEnd,
+                                        TriangleIntersectionResult& result) const
+{
+    if (nodes.isEmpty())
+        return false;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDirection(dir);
+
+    auto kernel = getSegmentTriangleKernel();
+    QVarLengthArray<int, BVH_MAX_LEAF_SIZE> hitSlots;
+    QVarLengthArray<float, BVH_MAX_LEAF_SIZE> hitTs;
+
+    float bestT = 1.0f;
+    int bestTri = -1;
+
+    struct StackEntry
+    {
+        int node;
+        float tEntry;
+    };
+
+    float tEntry;
+    if (!segmentHitsNode(nodes[0], segmentStart, dir, invDir, bestT, tEntry))
+        return false;
+
+    QVarLengthArray<StackEntry, 64> stack;
+    stack.append({0, tEntry});
+
+    while (!stack.isEmpty()) {
+        auto entry = stack.last();
+        stack.removeLast();
+
+        // a closer hit was found since this node was pushed
+        if (entry.tEntry > bestT)
+            continue;
+
+        const TriMeshBVHNode& node = nodes[entry.node];
+        if (node.count > 0) {
+            hitSlots.resize(node.count);
+            hitTs.resize(node.count);
+            int hitCount = kernel(leafTriangles, node.offset, node.count, segmentStart, segmentEnd, hitSlots.data(), hitTs.data());
+            for (int i = 0; i < hitCount; i++) {
+                int tri = triIndices[hitSlots[i]];
+                float t = hitTs[i];
+                if (bestTri < 0 || t < bestT || (t == bestT && tri < bestTri)) {
+                    bestT = t;
+                    bestTri = tri;
+                }
+            }
+            continue;
+        }
+
+        int left = entry.node + 1;
+        int right = node.offset;
+        float tLeft, tRight;
+        bool hitLeft = segmentHitsNode(nodes[left], segmentStart, dir, invDir, bestT, tLeft);
+        bool hitRight = segmentHitsNode(nodes[right], segmentStart, dir, invDir, bestT, tRight);
+
+        // nearer child goes on top of the stack
+        if (hitLeft && hitRight) {
+            if (tLeft <= tRight) {
+                stack.append({right, tRight});
+                stack.append({left, tLeft});
+            } else {
+                stack.append({left, tLeft});
+                stack.append({right, tRight});
+            }
+        } else if (hitLeft) {
+            stack.append({left, tLeft});
+        } else if (hitRight) {
+            stack.append({right, tRight});
+        }
+    }
+
+    if (bestTri < 0)
+        return false;
+
+    result.triangleIndex = bestTri;
+    result.hitPoint = segmentStart + dir * bestT;
+    result.t = bestT;
+    return true;
+}
+
+bool TriMeshBVH::isHitBySegment(const QVector3D& segmentStart,
+                                const QVector3D& segmentEnd,
+                                TriangleIntersectionResult& result) const
+{
+    if (nodes.isEmpty())
+        return false;
+
+    auto dir = segmentEnd - segmentStart;
+    auto invDir = inverseDirection(dir);
+
+    auto kernel = getSegmentTriangleKernel();
+    QVarLengthArray<int, BVH_MAX_LEAF_SIZE> hitSlots;
+    QVarLengthArray<float, BVH_MAX_LEAF_SIZE> hitTs;
+
+    QVarLengthArray<int, 64> stack;
+    stack.append(0);
+
+    while (!stack.isEmpty()) {
+        int nodeIndex = stack.last();
+        stack.removeLast();
+
+        const TriMeshBVHNode& node = nodes[nodeIndex];
+        float tEntry;
+        if (!segmentHitsNode(node, segmentStart, dir, invDir, 1.0f, tEntry))
+            continue;
+
+        if (node.count > 0) {
+            hitSlots.resize(node.count);
+            hitTs.resize(node.count);
+            if (kernel(leafTriangles, node.offset, node.count, segmentStart, segmentEnd, hitSlots.data(), hitTs.data())) {
+                result.triangleIndex = triIndices[hitSlots[0]];
+                result.hitPoint = segmentStart + dir * hitTs[0];
+                result.t = hitTs[0];
+                return true;
+            }
+        } else {
+            stack.append(node.offset);
+            stack.append(nodeIndex + 1);
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,83 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TRIMESHBVH_H
+#define TRIMESHBVH_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QList>
+
+#include "trianglekernel.h"
+
+namespace iris
+{
+
+class Triangle;
+struct TriangleIntersectionResult;
+
+struct TriMeshBVHNode
+{
+    QVector3D boundsMin;
+    QVector3D boundsMax;
+
+    // leaves: first entry in triIndices
+    // inner nodes: index of the right child, the left child always follows its parent
+    int offset;
+
+    // number of triangles in a leaf, 0 for inner nodes
+    int count;
+};
+
+/**
+ * Bounding volume hierarchy over a TriMesh's triangles.
+ * Built top-down with a binned surface area heuristic and stored as a flat
+ * depth-first array of nodes. Queries use the same triangle test as TriMesh
+ * so the hits are identical to testing every triangle.
+ */
+class TriMeshBVH
+{
+public:
+    QVector<TriMeshBVHNode> nodes;
+    QVector<int> triIndices;
+
+    // the triangles in triIndices order so each leaf is a contiguous run of slots
+    TriangleSoA leafTriangles;
+
+    static TriMeshBVH* build(const QList<Triangle>& triangles);
+
+    // every hit along the segment, sorted by triangle index
+    void getSegmentIntersections(const QVector3D& segmentStart,
+                                 const QVector3D& segmentEnd,
+                                 QList<TriangleIntersectionResult>& results) const;
+
+    // hit with the smallest t, ties go to the lowest triangle index
+    bool getClosestIntersection(const QVector3D& segmentStart,
+                                const QVector3D& segmentEnd,
+                                TriangleIntersectionResult& result) const;
+
+    // stops at the first hit found
+    bool isHitBySegment(const QVector3D& segmentStart,
+                        const QVector3D& segmentEnd,
+                        TriangleIntersectionResult& result) const;
+
+private:
+    int buildNode(int start, int count);
+
+    // only used while building
+    QVector<QVector3D> triMins;
+    QVector<QVector3D> triMaxs;
+    QVector<QVector3D> centroids;
+};
+
+}
+
+#endif // TRIMESHBVH_H
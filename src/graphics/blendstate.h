@@ -63,6 +63,22 @@ struct BlendState
 		//colorMask = ColorMask::Red | ColorMask::Green | ColorMask::Blue | ColorMask::Alpha;
     }
 
+    bool operator==(const BlendState& other) const
+    {
+        return colorSourceBlend == other.colorSourceBlend &&
+               alphaSourceBlend == other.alphaSourceBlend &&
+               colorDestBlend == other.colorDestBlend &&
+               alphaDestBlend == other.alphaDestBlend &&
+               colorBlendEquation == other.colorBlendEquation &&
+               alphaBlendEquation == other.alphaBlendEquation &&
+               colorMask == other.colorMask;
+    }
+
+    bool operator!=(const BlendState& other) const
+    {
+        return !(*this == other);
+    }
+
 	static BlendState createAlphaBlend();
 	static BlendState createOpaque();
 	static BlendState createAdditive();
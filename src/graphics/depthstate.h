@@ -25,6 +25,18 @@ struct DepthState
         depthCompareFunc = GL_LEQUAL;
     }
 
+    bool operator==(const DepthState& other) const
+    {
+        return depthBufferEnabled == other.depthBufferEnabled &&
+               depthWriteEnabled == other.depthWriteEnabled &&
+               depthCompareFunc == other.depthCompareFunc;
+    }
+
+    bool operator!=(const DepthState& other) const
+    {
+        return !(*this == other);
+    }
+
     static DepthState Default;
     static DepthState None;
 };
@@ -119,6 +119,20 @@ ForwardRenderer::ForwardRenderer(bool supportsVr, bool physicsEnabled)
     renderLightBillboards = true;
 	generateLightUnformNames();
 
+    instancingEnabled = true;
+    VertexLayout instanceLayout;
+    instanceLayout.addAttrib(VertexAttribUsage::InstanceWorldMatrix, GL_FLOAT, 16, sizeof(float) * 16, 1);
+    instanceBuffer = VertexBuffer::create(instanceLayout);
+    instanceBuffer->usage = GL_STREAM_DRAW;
+
+    cameraBlock = UniformBuffer::create();
+    fogBlock = UniformBuffer::create();
+    lightsBlock = UniformBuffer::create();
+
+    frustumCullingEnabled = true;
+    cullStamp = 0;
+    cullingStats = CullingStats();
+
 }
 
 void ForwardRenderer::generateShadowBuffer(GLuint size)
@@ -532,6 +546,7 @@ void ForwardRenderer::renderSceneVr(float delta, Viewport* vp, bool useViewer)
 
         auto proj = vrDevice->getEyeProjMatrix(eye,0.1f,1000.0f);
         renderData->projMatrix = proj;
+        renderData->frustum.build(proj * view);
 
         //STEP 1: RENDER SCENE
         renderData->scene = scene;
@@ -628,13 +643,41 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
         }
     }
 
-    scene->geometryRenderList->sort();
+    cullScene(renderData, scene);
+    uploadUniformBlocks(renderData, scene);
 
-    for (auto& item : scene->geometryRenderList->getItems()) {
+    scene->geometryRenderList->sort(renderData->eyePos);
+
+    const auto& items = scene->geometryRenderList->getItems();
+    for (int itemIndex = 0; itemIndex < items.size(); itemIndex++) {
+        auto item = items[itemIndex];
         if (item->type == iris::RenderItemType::Mesh && !!item->mesh) {
-            if (item->cullable) {
-                auto sphere = item->boundingSphere;
-                if (!renderData->frustum.isSphereInside(&sphere)) continue;
+            if (frustumCullingEnabled && item->cullable && item->cullStamp != cullStamp) {
+                cullingStats.culled++;
+                continue;
+            }
+            cullingStats.drawn++;
+
+            // sorting puts copies of the same mesh and material next to each other,
+            // gather the visible ones so they're drawn in a single call
+            int instanceCount = 1;
+            if (isInstanceable(item)) {
+                instanceData.clear();
+                appendInstance(item);
+
+                int nextIndex = itemIndex + 1;
+                for (; nextIndex < items.size() && canBatch(item, items[nextIndex]); nextIndex++) {
+                    auto other = items[nextIndex];
+                    if (frustumCullingEnabled && other->cullable && other->cullStamp != cullStamp) {
+                        cullingStats.culled++;
+                        continue;
+                    }
+                    cullingStats.drawn++;
+                    appendInstance(other);
+                    instanceCount++;
+                }
+
+                itemIndex = nextIndex - 1;
             }
 
             QOpenGLShaderProgram* program = nullptr;
@@ -646,118 +689,128 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
                 mat = item->material;
                 //program = mat->getProgram();
 
-                mat->begin(graphics, scene);
-				graphics->setShader(mat->shader);
+                if (instanceCount > 1) {
+                    mat->beginInstanced(graphics, scene);
+                } else {
+                    mat->begin(graphics, scene);
+                    graphics->setShader(mat->shader);
+                }
             } else {
                 program = item->shaderProgram;
                 program->bind();
             }
 
-            // send transform and light data
-			graphics->setShaderUniform("u_worldMatrix",   item->worldMatrix);
-			graphics->setShaderUniform("u_viewMatrix",    renderData->viewMatrix);
-			graphics->setShaderUniform("u_projMatrix",    renderData->projMatrix);
+            auto shader = graphics->getActiveShader();
+            bool usesCameraBlock = !!shader && shader->usesUniformBlock((int)UniformBlockBinding::Camera);
+            bool usesFogBlock = !!shader && shader->usesUniformBlock((int)UniformBlockBinding::Fog);
+            bool usesLightsBlock = !!shader && shader->usesUniformBlock((int)UniformBlockBinding::Lights);
+            bool fogEnabled = item->renderStates.fogEnabled && scene->fogEnabled;
 
-			graphics->setShaderUniform("u_time", scene->getRunningTime());
+            // send transform and light data
+			graphics->setShaderUniform(itemUniformNames.worldMatrix, item->worldMatrix);
+			graphics->setShaderUniform(itemUniformNames.normalMatrix, item->worldMatrix.normalMatrix());
 
             if  (item->mesh->hasSkeleton()) {
                 auto& boneTransforms = item->mesh->getSkeleton()->boneTransforms;
-                graphics->setShaderUniformArray("u_bones", boneTransforms.data(), boneTransforms.size());
-				
+                graphics->setShaderUniformArray(itemUniformNames.bones, boneTransforms.data(), boneTransforms.size());
 			}
 
-			graphics->setShaderUniform("u_normalMatrix",  item->worldMatrix.normalMatrix());
-
-			graphics->setShaderUniform("u_eyePos",        renderData->eyePos);
-			graphics->setShaderUniform("u_sceneAmbient",  QVector3D(scene->ambientColor.redF(),
-                                                                  scene->ambientColor.greenF(),
-                                                                  scene->ambientColor.blueF()));
+            // shaders that dont declare the uniform blocks get the per-frame data per draw
+            if (!usesCameraBlock) {
+				graphics->setShaderUniform(itemUniformNames.viewMatrix, renderData->viewMatrix);
+				graphics->setShaderUniform(itemUniformNames.projMatrix, renderData->projMatrix);
+				graphics->setShaderUniform(itemUniformNames.time, scene->getRunningTime());
+				graphics->setShaderUniform(itemUniformNames.eyePos, renderData->eyePos);
+				graphics->setShaderUniform(itemUniformNames.sceneAmbient, QVector3D(scene->ambientColor.redF(),
+                                                                                      scene->ambientColor.greenF(),
+                                                                                      scene->ambientColor.blueF()));
+            }
 
-            if (item->renderStates.fogEnabled && scene->fogEnabled ) {
-				graphics->setShaderUniform("u_fogData.color", renderData->fogColor);
-				graphics->setShaderUniform("u_fogData.start", renderData->fogStart);
-				graphics->setShaderUniform("u_fogData.end",   renderData->fogEnd);
+            if (usesFogBlock) {
+				graphics->setShaderUniform(itemUniformNames.fogBlockEnabled, fogEnabled);
+            } else if (fogEnabled) {
+				graphics->setShaderUniform(itemUniformNames.fogColor, renderData->fogColor);
+				graphics->setShaderUniform(itemUniformNames.fogStart, renderData->fogStart);
+				graphics->setShaderUniform(itemUniformNames.fogEnd,   renderData->fogEnd);
 
-				graphics->setShaderUniform("u_fogData.enabled", true);
+				graphics->setShaderUniform(itemUniformNames.fogEnabled, true);
             } else {
-				graphics->setShaderUniform("u_fogData.enabled", false);
+				graphics->setShaderUniform(itemUniformNames.fogEnabled, false);
             }
-            /*
-            if (item->renderStates.receiveShadows && scene->shadowEnabled) {
-                program->setUniformValue("u_shadowMap", 8);
-                program->setUniformValue("u_shadowEnabled", true);
-            } else {
-                program->setUniformValue("u_shadowEnabled", false);
-            }
-
-
-            gl->glActiveTexture(GL_TEXTURE8);
-            gl->glBindTexture(GL_TEXTURE_2D, shadowDepthMap);
-
-            program->setUniformValue("u_lightSpaceMatrix",  lightSpaceMatrix);
-            */
-            graphics->setShaderUniform("u_lightCount", static_cast<int>(renderData->scene->lights.count()));
 
 			// index at which shadow maps starts
 			// we're assuming that the gpu supports 32 texture units per shader
 			// gl 3.x spec dictates 16 minimum
             int shadowIndex = SHADOW_TEXTURE_SLOT_START;
 
-            // Only materials get lights passed to it
-            if ( item->renderStates.receiveLighting ) {
-				int lightUniformIndex = 0;
-				QHashIterator<QString, iris::LightNodePtr> iter(renderData->scene->lights);
-				while (iter.hasNext()) {
-					iter.next();
-
-					auto lightNames = this->lightUniformNames[lightUniformIndex++];
-
-                    auto light = iter.value();
-
-                    if (!light->isVisible()) {
-                        // Lasting hack for now (Nick)
-						graphics->setShaderUniform(lightNames.color.c_str(), QColor(0,0,0));
-                        continue;
-                    }
-
-					graphics->setShaderUniform(lightNames.type.c_str(), (int)light->lightType);
-					graphics->setShaderUniform(lightNames.position.c_str(), light->globalTransform.column(3).toVector3D());
-                    //mat->setUniformValue(lightPrefix+"direction", light->getDirection());
-					graphics->setShaderUniform(lightNames.distance.c_str(), light->distance);
-					graphics->setShaderUniform(lightNames.direction.c_str(), light->getLightDir());
-					graphics->setShaderUniform(lightNames.cutOffAngle.c_str(), light->spotCutOff);
-					graphics->setShaderUniform(lightNames.cutOffSoftness.c_str(), light->spotCutOffSoftness);
-					graphics->setShaderUniform(lightNames.intensity.c_str(), light->intensity);
-					graphics->setShaderUniform(lightNames.color.c_str(), light->color);
-
-					graphics->setShaderUniform(lightNames.shadowColor.c_str(), light->shadowColor);
-					graphics->setShaderUniform(lightNames.shadowAlpha.c_str(), light->shadowAlpha);
-
-					graphics->setShaderUniform(lightNames.constantAtten.c_str(), 1.0f);
-					graphics->setShaderUniform(lightNames.linearAtten.c_str(), 0.0f);
-					graphics->setShaderUniform(lightNames.quadAtten.c_str(), 1.0f);
-
-					if (!scene->shadowEnabled) {
-						graphics->setShaderUniform(lightNames.shadowType.c_str(), static_cast<int>(iris::ShadowMapType::None));
-					}
-					else {
-						graphics->setShaderUniform(lightNames.shadowMap.c_str(), shadowIndex);
-						graphics->setShaderUniform(lightNames.shadowMatrix.c_str(), light->shadowMap->shadowMatrix);
-						if (light->lightType == iris::LightType::Point)
-							graphics->setShaderUniform(lightNames.shadowType.c_str(), static_cast<int>(iris::ShadowMapType::None));
-						else
-							graphics->setShaderUniform(lightNames.shadowType.c_str(), static_cast<int>(light->shadowMap->shadowType));
-
+            if (usesLightsBlock) {
+                // light data is already in the block, only the shadow map samplers are per shader
+                if (item->renderStates.receiveLighting && scene->shadowEnabled) {
+                    graphics->setShaderUniformArray(itemUniformNames.shadowMaps, shadowMapSlots, UNIFORM_BLOCK_MAX_LIGHTS);
 
-						graphics->setTexture(shadowIndex, light->shadowMap->shadowTexture);
-						shadowIndex++;
-					}
+                    for (auto& shadowTexture : shadowMapTextures)
+                        graphics->setTexture(shadowIndex++, shadowTexture);
                 }
             }
+            else {
+				graphics->setShaderUniform(itemUniformNames.lightCount, static_cast<int>(renderData->scene->lights.count()));
+
+				// Only materials get lights passed to it
+				if ( item->renderStates.receiveLighting ) {
+					int lightUniformIndex = 0;
+					QHashIterator<QString, iris::LightNodePtr> iter(renderData->scene->lights);
+					while (iter.hasNext()) {
+						iter.next();
+
+						auto lightNames = this->lightUniformNames[lightUniformIndex++];
+
+						auto light = iter.value();
+
+						if (!light->isVisible()) {
+							// Lasting hack for now (Nick)
+							graphics->setShaderUniform(lightNames.color, QColor(0,0,0));
+							continue;
+						}
+
+						graphics->setShaderUniform(lightNames.type, (int)light->lightType);
+						graphics->setShaderUniform(lightNames.position, light->globalTransform.column(3).toVector3D());
+						//mat->setUniformValue(lightPrefix+"direction", light->getDirection());
+						graphics->setShaderUniform(lightNames.distance, light->distance);
+						graphics->setShaderUniform(lightNames.direction, light->getLightDir());
+						graphics->setShaderUniform(lightNames.cutOffAngle, light->spotCutOff);
+						graphics->setShaderUniform(lightNames.cutOffSoftness, light->spotCutOffSoftness);
+						graphics->setShaderUniform(lightNames.intensity, light->intensity);
+						graphics->setShaderUniform(lightNames.color, light->color);
+
+						graphics->setShaderUniform(lightNames.shadowColor, light->shadowColor);
+						graphics->setShaderUniform(lightNames.shadowAlpha, light->shadowAlpha);
+
+						graphics->setShaderUniform(lightNames.constantAtten, 1.0f);
+						graphics->setShaderUniform(lightNames.linearAtten, 0.0f);
+						graphics->setShaderUniform(lightNames.quadAtten, 1.0f);
+
+						if (!scene->shadowEnabled) {
+							graphics->setShaderUniform(lightNames.shadowType, static_cast<int>(iris::ShadowMapType::None));
+						}
+						else {
+							graphics->setShaderUniform(lightNames.shadowMap, shadowIndex);
+							graphics->setShaderUniform(lightNames.shadowMatrix, light->shadowMap->shadowMatrix);
+							if (light->lightType == iris::LightType::Point)
+								graphics->setShaderUniform(lightNames.shadowType, static_cast<int>(iris::ShadowMapType::None));
+							else
+								graphics->setShaderUniform(lightNames.shadowType, static_cast<int>(light->shadowMap->shadowType));
+
+
+							graphics->setTexture(shadowIndex, light->shadowMap->shadowTexture);
+							shadowIndex++;
+						}
+					}
+				}
+            }
 
 			// pass reflection shader
 			graphics->setTexture(SKY_CUBEMAP_TEXTURE_SLOT, scene->skyCapture);
-			graphics->setShaderUniform("skybox", SKY_CUBEMAP_TEXTURE_SLOT);
+			graphics->setShaderUniform(itemUniformNames.skybox, SKY_CUBEMAP_TEXTURE_SLOT);
 
             // set render states
             graphics->setRasterizerState(item->renderStates.rasterState);
@@ -765,7 +818,12 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
             graphics->setBlendState(item->renderStates.blendState);
 
             //item->mesh->draw(gl, program);
-			item->mesh->draw(graphics);
+            if (instanceCount > 1) {
+                instanceBuffer->setData(instanceData.data(), instanceData.size() * sizeof(float));
+                item->mesh->drawInstanced(graphics, instanceBuffer, instanceCount);
+            } else {
+                item->mesh->draw(graphics);
+            }
 
             if (!!mat) {
                 mat->end(graphics, scene);
@@ -779,6 +837,155 @@ void ForwardRenderer::renderNode(RenderData* renderData, ScenePtr scene)
 
 }
 
+bool ForwardRenderer::isInstanceable(RenderItem* item)
+{
+    return instancingEnabled &&
+           graphics->supportsInstancing() &&
+           !!item->material &&
+           item->material->supportsInstancing() &&
+           !item->mesh->hasSkeleton();
+}
+
+// items can share an instanced draw if nothing set per draw differs between them,
+// the draw uses the first item's material and states
+bool ForwardRenderer::canBatch(RenderItem* first, RenderItem* item)
+{
+    return item->type == iris::RenderItemType::Mesh &&
+           item->mesh == first->mesh &&
+           item->material == first->material &&
+           item->renderStates.rasterState == first->renderStates.rasterState &&
+           item->renderStates.depthState == first->renderStates.depthState &&
+           item->renderStates.blendState == first->renderStates.blendState &&
+           item->renderStates.receiveLighting == first->renderStates.receiveLighting &&
+           item->renderStates.fogEnabled == first->renderStates.fogEnabled;
+}
+
+void ForwardRenderer::appendInstance(RenderItem* item)
+{
+    // QMatrix4x4 carries extra flags so only the 16 floats are copied
+    auto matrix = item->worldMatrix.constData();
+    for (int i = 0; i < 16; i++)
+        instanceData.append(matrix[i]);
+}
+
+// Fills the camera, fog and light blocks once so shaders declaring them
+// dont need these uniforms set for every draw
+void ForwardRenderer::uploadUniformBlocks(RenderData* renderData, ScenePtr scene)
+{
+    CameraBlock camera;
+    copyToBlock(camera.viewMatrix, renderData->viewMatrix);
+    copyToBlock(camera.projMatrix, renderData->projMatrix);
+    copyToBlock(camera.eyePos, renderData->eyePos);
+    camera.time = scene->getRunningTime();
+    copyToBlock(camera.sceneAmbient, QVector3D(scene->ambientColor.redF(),
+                                               scene->ambientColor.greenF(),
+                                               scene->ambientColor.blueF()));
+    cameraBlock->setData(camera);
+
+    FogBlock fog;
+    copyToBlock(fog.color, renderData->fogColor);
+    fog.start = renderData->fogStart;
+    fog.end = renderData->fogEnd;
+    fogBlock->setData(fog);
+
+    LightsBlock lights;
+    memset(&lights, 0, sizeof(LightsBlock));
+
+    // lights are laid out the same way the per-draw path does it,
+    // hidden lights keep their index but contribute nothing
+    int lightIndex = 0;
+    int shadowIndex = SHADOW_TEXTURE_SLOT_START;
+    shadowMapTextures.clear();
+    for (auto light : renderData->scene->lights) {
+        if (lightIndex >= UNIFORM_BLOCK_MAX_LIGHTS)
+            break;
+
+        auto& data = lights.lights[lightIndex];
+        shadowMapSlots[lightIndex] = 0;
+        lightIndex++;
+
+        if (!light->isVisible())
+            continue;
+
+        data.type = (int)light->lightType;
+        copyToBlock(data.position, light->globalTransform.column(3).toVector3D());
+        data.distance = light->distance;
+        copyToBlock(data.direction, light->getLightDir());
+        data.cutOffAngle = light->spotCutOff;
+        data.cutOffSoftness = light->spotCutOffSoftness;
+        data.intensity = light->intensity;
+        copyToBlock(data.color, light->color);
+        copyToBlock(data.shadowColor, light->shadowColor);
+        data.shadowAlpha = light->shadowAlpha;
+
+        if (!scene->shadowEnabled) {
+            data.shadowType = static_cast<int>(iris::ShadowMapType::None);
+        }
+        else {
+            shadowMapSlots[lightIndex - 1] = shadowIndex++;
+            shadowMapTextures.append(light->shadowMap->shadowTexture);
+            copyToBlock(data.shadowMatrix, light->shadowMap->shadowMatrix);
+            if (light->lightType == iris::LightType::Point)
+                data.shadowType = static_cast<int>(iris::ShadowMapType::None);
+            else
+                data.shadowType = static_cast<int>(light->shadowMap->shadowType);
+        }
+    }
+    lights.lightCount = lightIndex;
+    lightsBlock->setData(lights);
+
+    graphics->setUniformBuffer((int)UniformBlockBinding::Camera, cameraBlock);
+    graphics->setUniformBuffer((int)UniformBlockBinding::Fog, fogBlock);
+    graphics->setUniformBuffer((int)UniformBlockBinding::Lights, lightsBlock);
+}
+
+void ForwardRenderer::cullScene(RenderData* renderData, ScenePtr scene)
+{
+    cullingStats = CullingStats();
+    if (!frustumCullingEnabled || !scene->rootNode)
+        return;
+
+    // items stamped with an older value are treated as culled
+    cullStamp++;
+    cullSceneNode(renderData, scene->rootNode, false);
+}
+
+// Walks the hierarchy testing each subtree's merged bounds against the frustum.
+// Subtrees that are outside are skipped entirely, subtrees that are completely
+// inside are accepted without testing any of their descendants
+void ForwardRenderer::cullSceneNode(RenderData* renderData, const SceneNodePtr& node, bool insideFrustum)
+{
+    // nothing in this subtree can be culled
+    if (node->subtreeBounds.isNull())
+        return;
+
+    if (!insideFrustum) {
+        cullingStats.tested++;
+        auto result = renderData->frustum.classifyAABB(node->subtreeBounds);
+        if (result == FrustumClassification::Outside)
+            return;
+
+        insideFrustum = result == FrustumClassification::Inside;
+    }
+
+    if (node->sceneNodeType == SceneNodeType::Mesh && !node->worldBounds.isNull()) {
+        bool visible = true;
+
+        // leaf bounds are the same as the subtree bounds that were just tested
+        if (!insideFrustum && node->hasChildren()) {
+            cullingStats.tested++;
+            visible = renderData->frustum.classifyAABB(node->worldBounds) != FrustumClassification::Outside;
+        }
+
+        if (visible)
+            node.staticCast<MeshNode>()->renderItem->cullStamp = cullStamp;
+    }
+
+    for (auto& child : node->children) {
+        cullSceneNode(renderData, child, insideFrustum);
+    }
+}
+
 void ForwardRenderer::renderSky(RenderData* renderData)
 {
     if (scene->skyMesh == nullptr) return;
@@ -1072,24 +1279,41 @@ void ForwardRenderer::generateLightUnformNames()
 	for (int i = 0; i < 16; i++) {
 		LightUniformNames names;
 		QString lightPrefix = QString("u_lights[%0].").arg(i);
-		names.color = (lightPrefix + "color").toStdString();
-		names.type = (lightPrefix + "type").toStdString();
-		names.position = (lightPrefix + "position").toStdString();
-		names.distance = (lightPrefix + "distance").toStdString();
-		names.direction = (lightPrefix + "direction").toStdString();
-		names.cutOffAngle = (lightPrefix + "cutOffAngle").toStdString();
-		names.cutOffSoftness = (lightPrefix + "cutOffSoftness").toStdString();
-		names.intensity = (lightPrefix + "intensity").toStdString();
-		names.shadowColor = (lightPrefix + "shadowColor").toStdString();
-		names.shadowAlpha = (lightPrefix + "shadowAlpha").toStdString();
-		names.constantAtten = (lightPrefix + "constantAtten").toStdString();
-		names.linearAtten = (lightPrefix + "linearAtten").toStdString();
-		names.quadAtten = (lightPrefix + "quadtraticAtten").toStdString();
-		names.shadowType = (lightPrefix + "shadowType").toStdString();
-		names.shadowMap = (lightPrefix + "shadowMap").toStdString();
-		names.shadowMatrix = (lightPrefix + "shadowMatrix").toStdString();
+		names.color = Shader::getUniformHandle((lightPrefix + "color").toUtf8());
+		names.type = Shader::getUniformHandle((lightPrefix + "type").toUtf8());
+		names.position = Shader::getUniformHandle((lightPrefix + "position").toUtf8());
+		names.distance = Shader::getUniformHandle((lightPrefix + "distance").toUtf8());
+		names.direction = Shader::getUniformHandle((lightPrefix + "direction").toUtf8());
+		names.cutOffAngle = Shader::getUniformHandle((lightPrefix + "cutOffAngle").toUtf8());
+		names.cutOffSoftness = Shader::getUniformHandle((lightPrefix + "cutOffSoftness").toUtf8());
+		names.intensity = Shader::getUniformHandle((lightPrefix + "intensity").toUtf8());
+		names.shadowColor = Shader::getUniformHandle((lightPrefix + "shadowColor").toUtf8());
+		names.shadowAlpha = Shader::getUniformHandle((lightPrefix + "shadowAlpha").toUtf8());
+		names.constantAtten = Shader::getUniformHandle((lightPrefix + "constantAtten").toUtf8());
+		names.linearAtten = Shader::getUniformHandle((lightPrefix + "linearAtten").toUtf8());
+		names.quadAtten = Shader::getUniformHandle((lightPrefix + "quadtraticAtten").toUtf8());
+		names.shadowType = Shader::getUniformHandle((lightPrefix + "shadowType").toUtf8());
+		names.shadowMap = Shader::getUniformHandle((lightPrefix + "shadowMap").toUtf8());
+		names.shadowMatrix = Shader::getUniformHandle((lightPrefix + "shadowMatrix").toUtf8());
 		lightUniformNames.append(names);
 	}
+
+	itemUniformNames.worldMatrix = Shader::getUniformHandle("u_worldMatrix");
+	itemUniformNames.viewMatrix = Shader::getUniformHandle("u_viewMatrix");
+	itemUniformNames.projMatrix = Shader::getUniformHandle("u_projMatrix");
+	itemUniformNames.time = Shader::getUniformHandle("u_time");
+	itemUniformNames.bones = Shader::getUniformHandle("u_bones");
+	itemUniformNames.normalMatrix = Shader::getUniformHandle("u_normalMatrix");
+	itemUniformNames.eyePos = Shader::getUniformHandle("u_eyePos");
+	itemUniformNames.sceneAmbient = Shader::getUniformHandle("u_sceneAmbient");
+	itemUniformNames.fogColor = Shader::getUniformHandle("u_fogData.color");
+	itemUniformNames.fogStart = Shader::getUniformHandle("u_fogData.start");
+	itemUniformNames.fogEnd = Shader::getUniformHandle("u_fogData.end");
+	itemUniformNames.fogEnabled = Shader::getUniformHandle("u_fogData.enabled");
+	itemUniformNames.fogBlockEnabled = Shader::getUniformHandle("u_fogEnabled");
+	itemUniformNames.lightCount = Shader::getUniformHandle("u_lightCount");
+	itemUniformNames.shadowMaps = Shader::getUniformHandle("u_shadowMaps");
+	itemUniformNames.skybox = Shader::getUniformHandle("skybox");
 }
 
 ForwardRenderer::~ForwardRenderer()
@@ -18,8 +18,9 @@ For more information see the LICENSE file
 //#include "../libovr/Include/OVR_CAPI_GL.h"
 #include "../irisglfwd.h"
 
-#include "particle.h"
+#include "particlepool.h"
 #include "particlerender.h"
+#include "uniformblocks.h"
 
 #define OUTLINE_STENCIL_CHANNEL 1
 
@@ -44,24 +45,56 @@ class PostProcessContext;
 class PerformanceTimer;
 class VrSwapChain;
 
+// uniform handles, see Shader::getUniformHandle
 struct LightUniformNames
 {
-	std::string color;
-	std::string type;
-	std::string position;
-	std::string distance;
-	std::string direction;
-	std::string cutOffAngle;
-	std::string cutOffSoftness;
-	std::string intensity;
-	std::string shadowColor;
-	std::string shadowAlpha;
-	std::string constantAtten;
-	std::string linearAtten;
-	std::string quadAtten;
-	std::string shadowType;
-	std::string shadowMap;
-	std::string shadowMatrix;
+	int color;
+	int type;
+	int position;
+	int distance;
+	int direction;
+	int cutOffAngle;
+	int cutOffSoftness;
+	int intensity;
+	int shadowColor;
+	int shadowAlpha;
+	int constantAtten;
+	int linearAtten;
+	int quadAtten;
+	int shadowType;
+	int shadowMap;
+	int shadowMatrix;
+};
+
+struct ItemUniformNames
+{
+	int worldMatrix;
+	int viewMatrix;
+	int projMatrix;
+	int time;
+	int bones;
+	int normalMatrix;
+	int eyePos;
+	int sceneAmbient;
+	int fogColor;
+	int fogStart;
+	int fogEnd;
+	int fogEnabled;
+	int fogBlockEnabled;
+	int lightCount;
+	int shadowMaps;
+	int skybox;
+};
+
+/**
+ * Counters for the last frustum culling pass
+ * tested is the number of bounding volume tests done while walking the hierarchy
+ */
+struct CullingStats
+{
+    int tested;
+    int culled;
+    int drawn;
 };
 
 /**
@@ -107,6 +140,23 @@ class ForwardRenderer
 
     PerformanceTimer* perfTimer;
 	QVector<LightUniformNames> lightUniformNames;
+	ItemUniformNames itemUniformNames;
+
+	// per-frame data shared by every shader that declares these blocks
+	UniformBufferPtr cameraBlock;
+	UniformBufferPtr fogBlock;
+	UniformBufferPtr lightsBlock;
+	int shadowMapSlots[UNIFORM_BLOCK_MAX_LIGHTS];
+	QVector<Texture2DPtr> shadowMapTextures;
+
+    bool frustumCullingEnabled;
+    unsigned int cullStamp;
+    CullingStats cullingStats;
+
+    // per-instance world matrices streamed for instanced draws
+    bool instancingEnabled;
+    VertexBufferPtr instanceBuffer;
+    QVector<float> instanceData;
 
 public:
 
@@ -138,6 +188,32 @@ public:
 
     static ForwardRendererPtr create(bool useVr = true, bool physicsEnabled = false);
 
+    void setFrustumCullingEnabled(bool enabled)
+    {
+        frustumCullingEnabled = enabled;
+    }
+
+    bool isFrustumCullingEnabled()
+    {
+        return frustumCullingEnabled;
+    }
+
+    CullingStats getCullingStats()
+    {
+        return cullingStats;
+    }
+
+    // consecutive items sharing a mesh and material are drawn with a single instanced call
+    void setInstancingEnabled(bool enabled)
+    {
+        instancingEnabled = enabled;
+    }
+
+    bool isInstancingEnabled()
+    {
+        return instancingEnabled;
+    }
+
     bool isVrSupported();
 	VrDevice* getVrDevice() { return vrDevice; }
 	void regenerateSwapChain();
@@ -148,6 +224,11 @@ private:
     ForwardRenderer(bool supportsVr = true, bool physicsEnabled = false);
 
     void renderNode(RenderData* renderData, ScenePtr node);
+    void cullScene(RenderData* renderData, ScenePtr scene);
+    void cullSceneNode(RenderData* renderData, const SceneNodePtr& node, bool insideFrustum);
+    bool isInstanceable(RenderItem* item);
+    bool canBatch(RenderItem* first, RenderItem* item);
+    void appendInstance(RenderItem* item);
     void renderSky(RenderData* renderData);
     void renderBillboardIcons(RenderData* renderData);
     void renderSelectedNode(RenderData* renderData, SceneNodePtr node);
@@ -171,6 +252,7 @@ private:
     void generateShadowBuffer(GLuint size = 1024);
 
 	void generateLightUnformNames();
+	void uploadUniformBlocks(RenderData* renderData, ScenePtr scene);
 
     //editor-specific
     iris::Billboard* billboard;
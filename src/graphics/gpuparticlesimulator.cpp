@@ -0,0 +1,114 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "gpuparticlesimulator.h"
+#include "graphicsdevice.h"
+#include "vertexlayout.h"
+#include "shader.h"
+
+// a_particle, a_particleParams and a_particleVelocity
+#define GPU_PARTICLE_FLOATS 12
+
+namespace iris
+{
+
+GpuParticleSimulator::GpuParticleSimulator()
+{
+    VertexLayout layout;
+    layout.addAttrib(iris::VertexAttribUsage::InstanceParticle, GL_FLOAT, 4, sizeof(float) * 4, 1);
+    layout.addAttrib(iris::VertexAttribUsage::InstanceParticleParams, GL_FLOAT, 4, sizeof(float) * 4, 1);
+    layout.addAttrib(iris::VertexAttribUsage::InstanceParticleVelocity, GL_FLOAT, 4, sizeof(float) * 4, 1);
+
+    // the buffers are rewritten by every update
+    for (int i = 0; i < 2; i++) {
+        buffers[i] = VertexBuffer::create(layout);
+        buffers[i]->usage = GL_DYNAMIC_COPY;
+    }
+
+    current = 0;
+    capacity = 0;
+    seed = 0;
+
+    reset();
+}
+
+void GpuParticleSimulator::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 0);
+    if (this->capacity == capacity)
+        return;
+
+    this->capacity = capacity;
+    reset();
+}
+
+void GpuParticleSimulator::reset()
+{
+    for (int i = 0; i < 2; i++)
+        buffers[i]->allocate(capacity * GPU_PARTICLE_FLOATS * sizeof(float));
+
+    current = 0;
+    needsClear = true;
+    emitSlot = 0;
+    emitIndex = 0;
+}
+
+void GpuParticleSimulator::simulate(GraphicsDevicePtr device, const GpuParticleStep& step)
+{
+    if (capacity == 0)
+        return;
+
+    if (!shader) {
+        shader = Shader::load(":/assets/shaders/particleupdate.vert", ":/assets/shaders/particleupdate.frag");
+        shader->setTransformFeedbackVaryings({"o_particle", "o_particleParams", "o_particleVelocity"});
+    }
+
+    int emitCount = qMin(step.emitCount, capacity);
+
+    device->setShader(shader);
+    device->setShaderUniform("delta", step.delta);
+    device->setShaderUniform("clear", needsClear ? 1 : 0);
+    device->setShaderUniform("capacity", capacity);
+    device->setShaderUniform("emitSlot", emitSlot);
+    device->setShaderUniform("emitCount", emitCount);
+    device->setShaderUniform("emitIndex", (GLuint) emitIndex);
+    device->setShaderUniform("seed", (GLuint) seed);
+
+    device->setShaderUniform("emitterPosition", step.emitterPosition);
+    device->setShaderUniform("emitDirection", step.emitDirection);
+    device->setShaderUniform("boundDimension", step.boundDimension);
+    device->setShaderUniform("speed", step.speed);
+    device->setShaderUniform("speedError", step.speedError);
+    device->setShaderUniform("particleScale", step.particleScale);
+    device->setShaderUniform("scaleError", step.scaleError);
+    device->setShaderUniform("lifeLength", step.lifeLength);
+    device->setShaderUniform("lifeError", step.lifeError);
+    device->setShaderUniform("gravity", step.gravity);
+    device->setShaderUniform("randomRotation", step.randomRotation ? 1 : 0);
+    device->setShaderUniform("dissipate", step.dissipate ? 1 : 0);
+    device->setShaderUniform("dissipateInv", step.dissipateInv ? 1 : 0);
+
+    // one point per slot, drawn instanced since the layout is per instance for the renderer
+    auto& source = buffers[current];
+    auto& target = buffers[1 - current];
+
+    device->setVertexBuffer(source);
+    device->beginTransformFeedback(target, GL_POINTS);
+    device->drawPrimitivesInstanced(GL_POINTS, 0, 1, capacity);
+    device->endTransformFeedback();
+
+    current = 1 - current;
+    needsClear = false;
+    emitSlot = (emitSlot + emitCount) % capacity;
+    emitIndex += emitCount;
+}
+
+}
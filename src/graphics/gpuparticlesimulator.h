@@ -0,0 +1,103 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef GPUPARTICLESIMULATOR_H
+#define GPUPARTICLESIMULATOR_H
+
+#include <QVector3D>
+#include "../irisglfwd.h"
+
+namespace iris
+{
+
+// emitter state for one update, recorded when the scene updates
+struct GpuParticleStep
+{
+    float delta;
+    int emitCount;
+
+    QVector3D emitterPosition;
+    // normalized
+    QVector3D emitDirection;
+    QVector3D boundDimension;
+
+    float speed, speedError;
+    float particleScale, scaleError;
+    float lifeLength, lifeError;
+    float gravity;
+
+    bool randomRotation;
+    bool dissipate, dissipateInv;
+};
+
+/**
+ * Simulates particles with transform feedback so they never leave the gpu.
+ * The state of every slot is in one vertex buffer, each update reads it and
+ * writes the next state into a second buffer and the two are swapped.
+ * Particles are emitted into the slots after the last emitted one, wrapping
+ * around, with the random values hashed from the seed and the particle's
+ * index. There is no live count so every slot is drawn, free ones with no size
+ */
+class GpuParticleSimulator
+{
+public:
+    GpuParticleSimulator();
+
+    // changing the capacity removes all particles
+    void setCapacity(int capacity);
+
+    int getCapacity()
+    {
+        return capacity;
+    }
+
+    void setSeed(quint32 seed)
+    {
+        this->seed = seed;
+    }
+
+    // removes all particles
+    void reset();
+
+    // needs a current context, runs a single update pass
+    void simulate(GraphicsDevicePtr device, const GpuParticleStep& step);
+
+    // false until the first update after a reset
+    bool hasState()
+    {
+        return !needsClear;
+    }
+
+    // one vertex per slot with InstanceParticle, InstanceParticleParams and InstanceParticleVelocity
+    VertexBufferPtr getParticleBuffer()
+    {
+        return buffers[current];
+    }
+
+private:
+    VertexBufferPtr buffers[2];
+    int current;
+    int capacity;
+
+    // the next update ignores the buffer's contents and starts with every slot free
+    bool needsClear;
+
+    int emitSlot;
+    // particles emitted so far, it picks each particle's random values
+    quint32 emitIndex;
+    quint32 seed;
+
+    ShaderPtr shader;
+};
+
+}
+
+#endif // GPUPARTICLESIMULATOR_H
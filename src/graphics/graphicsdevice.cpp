@@ -6,6 +6,7 @@
 #include "texturecube.h"
 #include "vertexlayout.h"
 #include "shader.h"
+#include "uniformblocks.h"
 
 #include <QOpenGLShaderProgram>
 #include <QOpenGLFunctions_3_2_Core>
@@ -21,6 +22,7 @@ VertexBuffer::VertexBuffer(VertexLayout vertexLayout)
     bufferId = -1;
     data = nullptr;
     dataSize = 0;
+    usage = GL_STATIC_DRAW;
     _isDirty = true;
 }
 
@@ -36,6 +38,18 @@ void VertexBuffer::setData(void *bufferData, unsigned int sizeInBytes)
     _isDirty = true;
 }
 
+void VertexBuffer::allocate(unsigned int sizeInBytes)
+{
+    if(data)
+        delete data;
+
+    // uploading without data only allocates
+    data = nullptr;
+    dataSize = sizeInBytes;
+
+    _isDirty = true;
+}
+
 void VertexBuffer::destroy()
 {
     if (data)
@@ -51,8 +65,7 @@ void VertexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
         gl->glGenBuffers(1, &bufferId);
 
     gl->glBindBuffer(GL_ARRAY_BUFFER, bufferId);
-    // todo : add buffer usage option (nick)
-    gl->glBufferData(GL_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW);
+    gl->glBufferData(GL_ARRAY_BUFFER, dataSize, data, usage);
     gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     _isDirty = false;
@@ -89,6 +102,8 @@ void IndexBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferId);
     gl->glBufferData(GL_ELEMENT_ARRAY_BUFFER, dataSize, data, GL_STATIC_DRAW);
     gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    _isDirty = false;
 }
 
 void IndexBuffer::destroy()
@@ -98,6 +113,67 @@ void IndexBuffer::destroy()
     // todo: delete gl buffer
 }
 
+UniformBuffer::UniformBuffer()
+{
+    bufferContext = nullptr;
+    bufferId = -1;
+    data = nullptr;
+    dataSize = 0;
+    _isDirty = true;
+}
+
+void UniformBuffer::setData(void *bufferData, unsigned int sizeInBytes)
+{
+    // blocks are rewritten every frame, only reallocate when the size changes
+    if (data && dataSize != sizeInBytes) {
+        delete[] (char*)data;
+        data = nullptr;
+    }
+
+    if (!data)
+        data = new char[sizeInBytes];
+    memcpy(this->data, bufferData, sizeInBytes);
+    dataSize = sizeInBytes;
+
+    _isDirty = true;
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    destroy();
+}
+
+void UniformBuffer::upload(QOpenGLFunctions_3_2_Core* gl)
+{
+    if (bufferId == -1) {
+        gl->glGenBuffers(1, &bufferId);
+        bufferContext = QOpenGLContext::currentContext();
+    }
+
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, bufferId);
+    gl->glBufferData(GL_UNIFORM_BUFFER, dataSize, data, GL_DYNAMIC_DRAW);
+    gl->glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    _isDirty = false;
+}
+
+void UniformBuffer::destroy()
+{
+    if (data) {
+        delete[] (char*)data;
+        data = nullptr;
+    }
+    dataSize = 0;
+
+    if (bufferId != -1 && !!bufferContext && bufferContext == QOpenGLContext::currentContext()) {
+        auto gl = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_2_Core>(bufferContext);
+        gl->glDeleteBuffers(1, &bufferId);
+    }
+    bufferId = -1;
+    bufferContext = nullptr;
+    _isDirty = true;
+}
+
 QOpenGLFunctions_3_2_Core *GraphicsDevice::getGL() const
 {
     return gl;
@@ -121,6 +197,10 @@ GraphicsDevice::GraphicsDevice()
 
     gl->glGenVertexArrays(1, &defautVAO);
 
+    vertexAttribDivisor = (VertexAttribDivisorFunc) context->getProcAddress("glVertexAttribDivisor");
+    if (!vertexAttribDivisor)
+        vertexAttribDivisor = (VertexAttribDivisorFunc) context->getProcAddress("glVertexAttribDivisorARB");
+
     _internalRT = RenderTarget::create(1024,1024);
 
     //set default blend and depth state
@@ -128,6 +208,10 @@ GraphicsDevice::GraphicsDevice()
     this->setDepthState(DepthState::Default, true);
     this->setRasterizerState(RasterizerState::CullCounterClockwise, true);
     activeProgram = nullptr;
+
+    registerUniformBlock("CameraData", (int)UniformBlockBinding::Camera);
+    registerUniformBlock("FogData", (int)UniformBlockBinding::Fog);
+    registerUniformBlock("LightsData", (int)UniformBlockBinding::Lights);
 }
 
 void GraphicsDevice::setViewport(const QRect& vp)
@@ -332,6 +416,22 @@ void GraphicsDevice::compileShader(iris::ShaderPtr shader)
 	program->bindAttributeLocation("a_tangent", (int)VertexAttribUsage::Tangent);
 	program->bindAttributeLocation("a_boneIndices", (int)VertexAttribUsage::BoneIndices);
 	program->bindAttributeLocation("a_boneWeights", (int)VertexAttribUsage::BoneWeights);
+	program->bindAttributeLocation("a_instanceWorldMatrix", (int)VertexAttribUsage::InstanceWorldMatrix);
+	program->bindAttributeLocation("a_particle", (int)VertexAttribUsage::InstanceParticle);
+	program->bindAttributeLocation("a_particleParams", (int)VertexAttribUsage::InstanceParticleParams);
+	program->bindAttributeLocation("a_particleVelocity", (int)VertexAttribUsage::InstanceParticleVelocity);
+
+	// which outputs get captured has to be set before linking
+	if (!shader->feedbackVaryings.isEmpty()) {
+		QList<QByteArray> varyingNames;
+		QVector<const char*> varyings;
+		for (auto& varying : shader->feedbackVaryings)
+			varyingNames.append(varying.toUtf8());
+		for (auto& name : varyingNames)
+			varyings.append(name.constData());
+
+		gl->glTransformFeedbackVaryings(program->programId(), varyings.size(), varyings.constData(), GL_INTERLEAVED_ATTRIBS);
+	}
 
 	if (!program->link()) {
 		shader->hasErrors = true;
@@ -399,6 +499,32 @@ void GraphicsDevice::compileShader(iris::ShaderPtr shader)
 
 	}
 
+	// seed the location cache so per-draw lookups never hit the driver
+	shader->clearUniformLocations();
+	for (auto sampler : shader->samplers)
+		shader->cacheUniformLocation(QByteArray::fromStdString(sampler->name), sampler->location);
+	for (auto uniform : shader->uniforms) {
+		auto uniformName = QByteArray::fromStdString(uniform->name);
+		shader->cacheUniformLocation(uniformName, uniform->location);
+
+		// arrays are reported as "name[0]" but are usually set using the base name
+		if (uniformName.endsWith("[0]"))
+			shader->cacheUniformLocation(uniformName.left(uniformName.length() - 3), uniform->location);
+	}
+
+	// assign registered uniform blocks to their binding points
+	gl->glGetProgramiv(programId, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+	for (int i = 0; i < count; i++)
+	{
+		gl->glGetActiveUniformBlockName(programId, i, bufSize, &length, name);
+		auto blockName = QString(name);
+		if (uniformBlockBindings.contains(blockName)) {
+			auto bindingPoint = uniformBlockBindings[blockName];
+			gl->glUniformBlockBinding(programId, i, bindingPoint);
+			shader->uniformBlockMask |= 1u << bindingPoint;
+		}
+	}
+
 	shader->isDirty = false;
 }
 
@@ -476,6 +602,19 @@ void GraphicsDevice::setIndexBuffer(IndexBufferPtr indexBuffer)
         this->indexBuffer.clear();
 }
 
+void GraphicsDevice::registerUniformBlock(const QString& blockName, int bindingPoint)
+{
+    Q_ASSERT(bindingPoint >= 0 && bindingPoint < 32);
+    uniformBlockBindings.insert(blockName, bindingPoint);
+}
+
+void GraphicsDevice::setUniformBuffer(int bindingPoint, UniformBufferPtr uniformBuffer)
+{
+    if (uniformBuffer->isDirty())
+        uniformBuffer->upload(gl);
+    gl->glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, uniformBuffer->bufferId);
+}
+
 void GraphicsDevice::clearIndexBuffer()
 {
     this->indexBuffer.clear();
@@ -639,8 +778,100 @@ void GraphicsDevice::drawIndexedPrimitives(GLenum primitiveType, int start, int
     gl->glBindVertexArray(0);
 }
 
+GLuint GraphicsDevice::createVertexArray(const QList<VertexBufferPtr>& vertexBuffers, IndexBufferPtr indexBuffer)
+{
+    GLuint vao;
+    gl->glGenVertexArrays(1, &vao);
+    gl->glBindVertexArray(vao);
+
+    for(auto buffer : vertexBuffers) {
+        if (buffer->isDirty())
+            buffer->upload(gl);
+        gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
+        buffer->vertexLayout.bind(gl, vertexAttribDivisor);
+    }
+
+    // the element buffer binding is part of the vao's state
+    if (!!indexBuffer) {
+        if (indexBuffer->isDirty())
+            indexBuffer->upload(gl);
+        gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->bufferId);
+    }
+
+    gl->glBindVertexArray(0);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return vao;
+}
+
+void GraphicsDevice::destroyVertexArray(GLuint vao)
+{
+    gl->glDeleteVertexArrays(1, &vao);
+}
 
+void GraphicsDevice::drawVertexArray(GLuint vao, GLenum primitiveType, int start, int count, bool indexed)
+{
+    gl->glBindVertexArray(vao);
+    if (indexed)
+        gl->glDrawElements(primitiveType, count, GL_UNSIGNED_INT, BUFFER_OFFSET(start));
+    else
+        gl->glDrawArrays(primitiveType, start, count);
+    gl->glBindVertexArray(0);
+}
 
+void GraphicsDevice::drawPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount)
+{
+    Q_ASSERT(supportsInstancing());
 
+    gl->glBindVertexArray(defautVAO);
+    for(auto buffer : vertexBuffers) {
+        gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
+        buffer->vertexLayout.bind(gl, vertexAttribDivisor);
+    }
+
+    gl->glDrawArraysInstanced(primitiveType, start, count, instanceCount);
+
+    for(auto buffer : vertexBuffers) {
+        buffer->vertexLayout.unbind(gl, vertexAttribDivisor);
+    }
+    gl->glBindVertexArray(0);
+}
+
+void GraphicsDevice::drawIndexedPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount)
+{
+    Q_ASSERT(supportsInstancing());
+
+    gl->glBindVertexArray(defautVAO);
+    for(auto buffer : vertexBuffers) {
+        gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
+        buffer->vertexLayout.bind(gl, vertexAttribDivisor);
+    }
+
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,indexBuffer->bufferId);
+    gl->glDrawElementsInstanced(primitiveType,count,GL_UNSIGNED_INT,BUFFER_OFFSET(start),instanceCount);
+    gl->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+
+    for(auto buffer : vertexBuffers) {
+        buffer->vertexLayout.unbind(gl, vertexAttribDivisor);
+    }
+    gl->glBindVertexArray(0);
+}
+
+void GraphicsDevice::beginTransformFeedback(VertexBufferPtr buffer, GLenum primitiveType)
+{
+    if (buffer->isDirty())
+        buffer->upload(gl);
+
+    gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer->bufferId);
+    gl->glEnable(GL_RASTERIZER_DISCARD);
+    gl->glBeginTransformFeedback(primitiveType);
+}
+
+void GraphicsDevice::endTransformFeedback()
+{
+    gl->glEndTransformFeedback();
+    gl->glDisable(GL_RASTERIZER_DISCARD);
+    gl->glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+}
 
 }
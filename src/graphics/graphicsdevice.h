@@ -7,6 +7,7 @@
 #include <QRect>
 #include <QStack>
 #include "vertexlayout.h"
+#include "shader.h"
 #include "blendstate.h"
 #include "depthstate.h"
 #include "rasterizerstate.h"
@@ -22,6 +23,8 @@ class VertexBuffer;
 typedef QSharedPointer<VertexBuffer> VertexBufferPtr;
 class IndexBuffer;
 typedef QSharedPointer<IndexBuffer> IndexBufferPtr;
+class UniformBuffer;
+typedef QSharedPointer<UniformBuffer> UniformBufferPtr;
 
 class VertexBuffer
 {
@@ -34,6 +37,9 @@ public:
     VertexLayout vertexLayout;
     GraphicsDevicePtr device;
 
+    // GL_STREAM_DRAW for buffers that are refilled every frame
+    GLenum usage;
+
     bool _isDirty;
 
     static VertexBufferPtr create(VertexLayout vertexLayout)
@@ -49,6 +55,9 @@ public:
 
     void setData(void* data, unsigned int sizeinBytes);
 
+    // storage for buffers only the gpu writes to, the contents are undefined until then
+    void allocate(unsigned int sizeInBytes);
+
     bool isDirty()
     {
         return _isDirty;
@@ -93,6 +102,47 @@ private:
     void destroy();
 };
 
+/*
+ * Backs a std140 uniform block. The data is expected to be rewritten
+ * every frame so it's uploaded with GL_DYNAMIC_DRAW
+ */
+class UniformBuffer
+{
+    friend class GraphicsDevice;
+public:
+    void* data;
+    GLuint bufferId;
+    int dataSize;
+    bool _isDirty;
+
+    template<typename T>
+    void setData(const T& block)
+    {
+        setData((void*) &block, sizeof(T));
+    }
+
+    void setData(void* data, unsigned int sizeInBytes);
+
+    bool isDirty()
+    {
+        return _isDirty;
+    }
+
+    static UniformBufferPtr create()
+    {
+        return UniformBufferPtr(new UniformBuffer());
+    }
+
+    ~UniformBuffer();
+private:
+    UniformBuffer();
+    void upload(QOpenGLFunctions_3_2_Core* gl);
+    void destroy();
+
+    // the gl buffer can only be deleted while this context is current
+    QOpenGLContext* bufferContext;
+};
+
 /*
  * This class is intended to wrap all calls to opengl with simpler
  * and easier-to-use functions
@@ -114,10 +164,16 @@ class GraphicsDevice
     // before you can render anything
     GLuint defautVAO;
 
+    // null if neither gl 3.3 nor ARB_instanced_arrays is available
+    VertexAttribDivisorFunc vertexAttribDivisor;
+
     ShaderPtr activeShader;
     // comes from active shader for ease-of-access
     QOpenGLShaderProgram* activeProgram;
 
+    // uniform block name to binding point, applied to shaders when they're compiled
+    QHash<QString, int> uniformBlockBindings;
+
     bool lastBlendEnabled;
     BlendState lastBlendState;
     DepthState lastDepthState;
@@ -142,28 +198,50 @@ public:
 	// if force is set to true, texture units will be reset regardless if the shader
 	// being bound is already bound
     void setShader(ShaderPtr shader, bool force = false);
+    ShaderPtr getActiveShader() {
+        return activeShader;
+    }
+
+    // uniform locations are cached per shader, see Shader::getUniformHandle
+    template<typename T>
+    void setShaderUniform(int handle, const T& value) {
+        if (activeProgram)
+            activeProgram->setUniformValue(activeShader->getUniformLocation(handle), value);
+    }
     template<typename T>
     void setShaderUniform(const QString& name,const T& value) {
         if (activeProgram)
-            activeProgram->setUniformValue(name.toStdString().c_str(), value);
+            activeProgram->setUniformValue(activeShader->getUniformLocation(name.toUtf8()), value);
     }
     template<typename T>
     void setShaderUniform(const char* name,const T& value) {
         if (activeProgram)
-            activeProgram->setUniformValue(name, value);
+            activeProgram->setUniformValue(activeShader->getUniformLocation(QByteArray::fromRawData(name, strlen(name))), value);
     }
 
+	template<typename T>
+	void setShaderUniformArray(int handle, const T* value, const unsigned int count) {
+		if (activeProgram)
+			activeProgram->setUniformValueArray(activeShader->getUniformLocation(handle), value, count);
+	}
 	template<typename T>
 	void setShaderUniformArray(const QString& name, const T* value, const unsigned int count) {
 		if (activeProgram)
-			activeProgram->setUniformValueArray(name.toStdString().c_str(), value);
+			activeProgram->setUniformValueArray(activeShader->getUniformLocation(name.toUtf8()), value, count);
 	}
 	template<typename T>
 	void setShaderUniformArray(const char* name, const T* value, const unsigned int count) {
 		if (activeProgram)
-			activeProgram->setUniformValueArray(name, value, count);
+			activeProgram->setUniformValueArray(activeShader->getUniformLocation(QByteArray::fromRawData(name, strlen(name))), value, count);
 	}
 
+    /*
+     * Shaders declaring a uniform block with this name will have it assigned to bindingPoint
+     * Blocks should be registered before any shader using them is compiled
+     */
+    void registerUniformBlock(const QString& blockName, int bindingPoint);
+    void setUniformBuffer(int bindingPoint, UniformBufferPtr uniformBuffer);
+
     void setTexture(int target, TexturePtr texture);
     void clearTexture(int target);
 	void compileShader(iris::ShaderPtr shader);
@@ -180,6 +258,32 @@ public:
 
     void drawPrimitives(GLenum primitiveType,int start, int count);
     void drawIndexedPrimitives(GLenum primitiveType,int start, int count);
+
+    /*
+     * Vertex array objects capture the attribute setup of a set of buffers
+     * so drawing them later is a single bind. They're only valid in the
+     * context they were created in
+     */
+    GLuint createVertexArray(const QList<VertexBufferPtr>& vertexBuffers, IndexBufferPtr indexBuffer);
+    void destroyVertexArray(GLuint vao);
+    void drawVertexArray(GLuint vao, GLenum primitiveType, int start, int count, bool indexed);
+
+    bool supportsInstancing()
+    {
+        return vertexAttribDivisor != nullptr;
+    }
+
+    // vertex buffers with per-instance attributes should be set along with the mesh's buffers
+    void drawPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount);
+    void drawIndexedPrimitivesInstanced(GLenum primitiveType, int start, int count, int instanceCount);
+
+    /*
+     * Draws between these calls write the active shader's feedback varyings
+     * into buffer instead of rasterizing, see Shader::setTransformFeedbackVaryings
+     * primitiveType must match the draws, buffer can't be one of the vertex buffers
+     */
+    void beginTransformFeedback(VertexBufferPtr buffer, GLenum primitiveType);
+    void endTransformFeedback();
     QOpenGLFunctions_3_2_Core *getGL() const;
 
     static GraphicsDevicePtr create();
@@ -41,6 +41,33 @@ void Material::beginCube(GraphicsDevicePtr device,ScenePtr scene)
     this->bindCubeTextures(device);
 }
 
+bool Material::supportsInstancing()
+{
+	return !!shader && shader->supportsInstancing();
+}
+
+void Material::beginInstanced(GraphicsDevicePtr device, ScenePtr scene)
+{
+	// rebuild the variant if the material's shader was replaced
+	if (instancedShaderSource != shader) {
+		instancedShader = Shader::create(shader->vertexShader, shader->fragmentShader);
+		instancedShaderSource = shader;
+	}
+
+	auto instancedFlags = shader->flags;
+	instancedFlags.insert("INSTANCING_ENABLED");
+	if (instancedShader->flags != instancedFlags) {
+		instancedShader->flags = instancedFlags;
+		instancedShader->_setDirty();
+	}
+
+	// subclasses bind whatever is in shader so swap it for the duration of begin
+	auto baseShader = shader;
+	shader = instancedShader;
+	begin(device, scene);
+	shader = baseShader;
+}
+
 void Material::end(GraphicsDevicePtr device,ScenePtr scene)
 {
     this->unbindTextures(device);
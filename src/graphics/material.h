@@ -91,6 +91,17 @@ public:
     virtual void begin(GraphicsDevicePtr device, ScenePtr scene);
     virtual void beginCube(GraphicsDevicePtr device, ScenePtr scene);
 
+    /**
+     * True if the material's vertex shader has an INSTANCING_ENABLED path
+     */
+    bool supportsInstancing();
+
+    /**
+     * Same as begin but binds a variant of the shader compiled with INSTANCING_ENABLED
+     * World matrices are then read from the a_instanceWorldMatrix attribute
+     */
+    void beginInstanced(GraphicsDevicePtr device, ScenePtr scene);
+
     /**
      * Called after endering a pritimitive.
      * This is used to cleanup after rendering
@@ -150,6 +161,10 @@ protected:
 
 	QSet<QString> flags;
 
+	// created the first time the material is drawn instanced
+	ShaderPtr instancedShader;
+	ShaderPtr instancedShaderSource;
+
 	QOpenGLShaderProgram* getProgram();
 };
 
@@ -16,6 +16,8 @@ For more information see the LICENSE file
 #include <QFile>
 #include <QOpenGLBuffer>
 #include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLVersionFunctionsFactory>
+#include <QOpenGLContext>
 #include <QOpenGLTexture>
 #include <QtMath>
 
@@ -32,6 +34,7 @@ For more information see the LICENSE file
 #include "vertexlayout.h"
 #include "../geometry/trimesh.h"
 #include "skeleton.h"
+#include "skinning.h"
 #include "../geometry/boundingsphere.h"
 #include "../geometry/aabb.h"
 
@@ -60,10 +63,15 @@ QMatrix4x4 aiMatrixToQMatrix(aiMatrix4x4 aiMat) {
 Mesh::Mesh()
 {
 	triMesh = nullptr;
+	skinData = nullptr;
 	_isDirty = 0;
 	lastShaderId = -1;
 	numVerts = 0;
 	usesIndexBuffer = false;
+	vao = 0;
+	vaoContext = nullptr;
+	vaoLayoutVersion = 0;
+	layoutVersion = 0;
 }
 
 // http://ogldev.atspace.co.uk/www/tutorial38/tutorial38.html
@@ -71,9 +79,14 @@ Mesh::Mesh(aiMesh* mesh)
 {
 	_isDirty = 0;
     lastShaderId = -1;
+    vao = 0;
+    vaoContext = nullptr;
+    vaoLayoutVersion = 0;
+    layoutVersion = 0;
     //gl = QOpenGLContext::currentContext()->versionFunctions<QOpenGLFunctions_3_2_Core>();
 
     triMesh = new TriMesh();
+    skinData = nullptr;
 
     this->vertexLayout = nullptr;
     numVerts = mesh->mNumFaces*3;
@@ -138,6 +151,18 @@ Mesh::Mesh(aiMesh* mesh)
         //this->addVertexArray(VertexAttribUsage::BoneIndices, (void*)boneIndices.data(), sizeof(int) * boneIndices.size(), GL_INT, MAX_BONE_INDICES);
         this->addVertexArray(VertexAttribUsage::BoneIndices, (void*)boneIndices.data(), sizeof(float) * boneIndices.size(), GL_FLOAT, MAX_BONE_INDICES);
         this->addVertexArray(VertexAttribUsage::BoneWeights, (void*)boneWeights.data(), sizeof(float) * boneWeights.size(), GL_FLOAT, MAX_BONE_INDICES);
+
+        // kept for posing the mesh on the cpu, see MeshNode::setCpuSkinningEnabled
+        skinData = new SkinData();
+        skinData->positions.reserve(mesh->mNumVertices);
+        for (unsigned i = 0; i < mesh->mNumVertices; i++) {
+            auto vert = mesh->mVertices[i];
+            skinData->positions.append(QVector4D(vert.x, vert.y, vert.z, 1.0f));
+        }
+        skinData->boneIndices.reserve(boneIndices.size());
+        for (auto index : boneIndices)
+            skinData->boneIndices.append((int)index);
+        skinData->boneWeights = boneWeights;
     }
 
     // Assimp doesnt give the indices in an array
@@ -166,6 +191,9 @@ Mesh::Mesh(aiMesh* mesh)
                              QVector3D(c.x, c.y, c.z));
     }
 
+    if (skinData != nullptr)
+        skinData->indices = indices;
+
     usesIndexBuffer = true;
     idxBuffer = IndexBuffer::create();
     idxBuffer->setData(indices.data(), sizeof(unsigned int) * indices.size());
@@ -182,7 +210,12 @@ Mesh::Mesh(void* data,int dataSize,int numElements,VertexLayout* vertexLayout)
 {
     lastShaderId = -1;
     triMesh = nullptr;
+    skinData = nullptr;
     numVerts = numElements;
+    vao = 0;
+    vaoContext = nullptr;
+    vaoLayoutVersion = 0;
+    layoutVersion = 0;
 
     auto vb = VertexBuffer::create(*vertexLayout);
     vb->setData(data, dataSize);
@@ -228,16 +261,19 @@ void Mesh::setPrimitiveMode(const PrimitiveMode &value)
 void Mesh::clearVertexBuffers()
 {
     this->vertexBuffers.clear();
+    invalidateVertexArray();
 }
 
 void Mesh::addVertexBuffer(VertexBufferPtr vertexBuffer)
 {
     this->vertexBuffers.append(vertexBuffer);
+    invalidateVertexArray();
 }
 
 void Mesh::setIndexBuffer(IndexBufferPtr indexBuffer)
 {
     this->idxBuffer = indexBuffer;
+    invalidateVertexArray();
 }
 
 bool Mesh::hasSkeleton()
@@ -271,12 +307,48 @@ void Mesh::draw(GraphicsDevicePtr device)
 	if (numVerts == 0)
 		return;
 
-    device->setVertexBuffers(vertexBuffers);
+    auto context = QOpenGLContext::currentContext();
+    if (vao == 0 || vaoContext != context || vaoLayoutVersion != layoutVersion) {
+        // vaos arent shared between contexts so the old one can only be freed in its own
+        if (vao != 0 && vaoContext == context)
+            device->destroyVertexArray(vao);
+
+        // uploads the dirty buffers too
+        vao = device->createVertexArray(vertexBuffers, idxBuffer);
+        vaoContext = context;
+        vaoLayoutVersion = layoutVersion;
+    } else if (hasDirtyBuffers()) {
+        // the vao references the buffers by id so new data only needs uploading
+        device->setVertexBuffers(vertexBuffers);
+        if (!!idxBuffer)
+            device->setIndexBuffer(idxBuffer);
+    }
+
+    device->drawVertexArray(vao, glPrimitive, 0, numVerts, !!idxBuffer);
+}
+
+bool Mesh::hasDirtyBuffers() const
+{
+    for (const auto& buffer : vertexBuffers)
+        if (buffer->isDirty())
+            return true;
+
+    return !!idxBuffer && idxBuffer->isDirty();
+}
+
+void Mesh::drawInstanced(GraphicsDevicePtr device, VertexBufferPtr instanceBuffer, int instanceCount)
+{
+	if (numVerts == 0 || instanceCount == 0)
+		return;
+
+    auto buffers = vertexBuffers;
+    buffers.append(instanceBuffer);
+    device->setVertexBuffers(buffers);
     if (!!idxBuffer) {
         device->setIndexBuffer(idxBuffer);
-        device->drawIndexedPrimitives(glPrimitive, 0, numVerts);
+        device->drawIndexedPrimitivesInstanced(glPrimitive, 0, numVerts, instanceCount);
     } else {
-        device->drawPrimitives(glPrimitive, 0, numVerts);
+        device->drawPrimitivesInstanced(glPrimitive, 0, numVerts, instanceCount);
     }
 }
 
@@ -419,6 +491,12 @@ Mesh::~Mesh()
     //delete vertexLayout;
 	if (triMesh)
 		delete triMesh;
+    delete skinData;
+
+    if (vao != 0 && vaoContext == QOpenGLContext::currentContext()) {
+        auto gl = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_2_Core>(vaoContext);
+        gl->glDeleteVertexArrays(1, &vao);
+    }
 }
 
 void Mesh::setVertexCount(const unsigned int count)
@@ -439,6 +517,7 @@ void Mesh::addVertexArray(VertexAttribUsage usage,void* dataPtr,int size,GLenum
     auto vb = VertexBuffer::create(layout);
     vb->setData(dataPtr, size);
     vertexBuffers.append(vb);
+    invalidateVertexArray();
 }
 
 void Mesh::addIndexArray(void* data,int size,GLenum type)
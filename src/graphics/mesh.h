@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #define MESH_H
 
 #include <QString>
+#include <QVector>
 #include <qopengl.h>
 #include <QColor>
 
@@ -27,12 +28,14 @@ class aiMesh;
 class QOpenGLBuffer;
 class QOpenGLFunctions_3_2_Core;
 class QOpenGLShaderProgram;
+class QOpenGLContext;
 
 
 namespace iris
 {
 
 class BoundingSphere;
+struct SkinData;
 
 enum class VertexAttribUsage : int
 {
@@ -47,7 +50,20 @@ enum class VertexAttribUsage : int
     BiTangent = 8,
     BoneIndices = 9,
     BoneWeights = 10,
-    Count = 11
+    Count = 11,
+
+    // per-instance attributes, these are never stored in meshes
+    // matrices take up one location per column (12 to 15)
+    InstanceWorldMatrix = 12,
+
+    // particles have no world matrix so they reuse its locations
+    // xyz is the position and w the scale
+    InstanceParticle = 12,
+    // x is the rotation in degrees and y the age from 0 to 1
+    // gpu simulated particles also keep the elapsed time in z and the life length in w
+    InstanceParticleParams = 13,
+    // xyz is the velocity and w the gravity effect, only used by gpu simulated particles
+    InstanceParticleVelocity = 14
 };
 
 struct MeshMaterialData
@@ -109,7 +125,14 @@ class Mesh
 public:
     PrimitiveMode primitiveMode;
     QOpenGLFunctions_3_2_Core* gl;
+
+    // built on the first draw and rebuilt when the buffers or their layouts change
     GLuint vao;
+    QOpenGLContext* vaoContext;
+    // layoutVersion when vao was built
+    unsigned int vaoLayoutVersion;
+    // bumped whenever a vertex or index buffer is added, removed or replaced
+    unsigned int layoutVersion;
     GLuint indexBuffer;
     bool usesIndexBuffer;
 	bool _isDirty;
@@ -133,6 +156,9 @@ public:
         return triMesh;
     }
 
+    // cpu copy of the vertices and bone weights, null if the mesh has no bones
+    SkinData* skinData;
+
 
     bool hasSkeleton();
     SkeletonPtr getSkeleton();
@@ -145,6 +171,9 @@ public:
     //void draw(QOpenGLFunctions_3_2_Core* gl, QOpenGLShaderProgram* mat);
     void draw(GraphicsDevicePtr device);
 
+    // draws instanceCount copies using the per-instance attributes in instanceBuffer
+    void drawInstanced(GraphicsDevicePtr device, VertexBufferPtr instanceBuffer, int instanceCount);
+
     static MeshPtr loadMesh(QString filePath);
     static MeshPtr loadAnimatedMesh(QString filePath);
     static SkeletonPtr extractSkeleton(const aiMesh* mesh, const aiScene* scene);
@@ -223,14 +252,27 @@ public:
     PrimitiveMode getPrimitiveMode() const;
     void setPrimitiveMode(const PrimitiveMode &value);
 
+    /*
+     * A buffer's vertex layout is captured in the mesh's vao when it's drawn
+     * Call invalidateVertexArray after changing the layout of a buffer that
+     * was already added
+     */
     void clearVertexBuffers();
 	void addVertexBuffer(VertexBufferPtr vertexBuffer);
 	void setIndexBuffer(IndexBufferPtr indexBuffer);
 
+    void invalidateVertexArray()
+    {
+        layoutVersion++;
+    }
+
 	AABB getAABB(){return aabb;}
 	BoundingSphere getBoundingSphere() { return boundingSphere; }
 
 private:
+    // true if a buffer's data changed since it was last uploaded
+    bool hasDirtyBuffers() const;
+
     void addVertexArray(VertexAttribUsage usage,void* data,int size,GLenum type,int numComponents);
     void addIndexArray(void* data,int size,GLenum type);
 
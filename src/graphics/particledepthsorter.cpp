@@ -0,0 +1,180 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "particledepthsorter.h"
+#include "particlepool.h"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+// largest change in any view matrix element that still counts as the camera barely moving
+#define PARTICLE_SORT_VIEW_TOLERANCE 0.05f
+// insertion sort gives up after this many moves per particle
+#define PARTICLE_SORT_MAX_MOVES 2
+
+namespace iris
+{
+
+ParticleDepthSorter::ParticleDepthSorter()
+{
+    hasOrder = false;
+}
+
+void ParticleDepthSorter::reset()
+{
+    order.clear();
+    hasOrder = false;
+}
+
+void ParticleDepthSorter::sort(const ParticlePool& particles, const QMatrix4x4& viewMatrix)
+{
+    int count = particles.count;
+
+    // slots that are still alive keep their place, new ones are added at the end.
+    // order always holds every slot below the previous count exactly once
+    int previousCount = hasOrder ? order.size() : 0;
+    if (!hasOrder)
+        order.clear();
+
+    int* o = order.data();
+    int kept = 0;
+    for (int i = 0; i < order.size(); i++) {
+        if (o[i] < count)
+            o[kept++] = o[i];
+    }
+    order.resize(kept);
+    for (int slot = previousCount; slot < count; slot++)
+        order.append(slot);
+
+    updateKeys(particles, viewMatrix);
+
+    bool cameraMoved = !hasOrder;
+    for (int i = 0; i < 16 && !cameraMoved; i++) {
+        if (std::fabs(viewMatrix.constData()[i] - lastViewMatrix.constData()[i]) > PARTICLE_SORT_VIEW_TOLERANCE)
+            cameraMoved = true;
+    }
+
+    if (cameraMoved || !insertionSort(count * PARTICLE_SORT_MAX_MOVES))
+        radixSort();
+
+    lastViewMatrix = viewMatrix;
+    hasOrder = true;
+}
+
+// smaller keys are farther away
+void ParticleDepthSorter::updateKeys(const ParticlePool& particles, const QMatrix4x4& viewMatrix)
+{
+    int count = particles.count;
+    keys.resize(count);
+    if (count == 0)
+        return;
+
+    // distance in front of the camera is -z in view space
+    float m20 = viewMatrix(2, 0);
+    float m21 = viewMatrix(2, 1);
+    float m22 = viewMatrix(2, 2);
+    float m23 = viewMatrix(2, 3);
+
+    const float* px = particles.positionX.constData();
+    const float* py = particles.positionY.constData();
+    const float* pz = particles.positionZ.constData();
+
+    depths.resize(count);
+    float* d = depths.data();
+
+    float minDepth = INFINITY;
+    float maxDepth = -INFINITY;
+    for (int i = 0; i < count; i++) {
+        float depth = -(m20 * px[i] + m21 * py[i] + m22 * pz[i] + m23);
+        d[i] = depth;
+        minDepth = qMin(minDepth, depth);
+        maxDepth = qMax(maxDepth, depth);
+    }
+
+    float range = maxDepth - minDepth;
+    float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+
+    quint16* k = keys.data();
+    for (int i = 0; i < count; i++) {
+        float q = qBound(0.0f, (d[i] - minDepth) * scale, 65535.0f);
+        k[i] = quint16(65535 - int(q));
+    }
+}
+
+// returns false if it ran out of moves, order is still a valid permutation then
+bool ParticleDepthSorter::insertionSort(int maxMoves)
+{
+    int* o = order.data();
+    const quint16* k = keys.constData();
+    int moves = 0;
+
+    for (int i = 1; i < order.size(); i++) {
+        int slot = o[i];
+        quint16 key = k[slot];
+
+        int j = i;
+        while (j > 0 && k[o[j - 1]] > key) {
+            o[j] = o[j - 1];
+            j--;
+        }
+        o[j] = slot;
+
+        moves += i - j;
+        if (moves > maxMoves)
+            return false;
+    }
+
+    return true;
+}
+
+// two stable 8 bit passes, low byte first. The keys are gathered next to
+// their slots first so the passes only read sequentially
+void ParticleDepthSorter::radixSort()
+{
+    int count = order.size();
+    sortKeys.resize(count * 2);
+    sortSlots.resize(count * 2);
+
+    const quint16* k = keys.constData();
+    int* o = order.data();
+
+    quint16* srcKeys = sortKeys.data();
+    quint16* dstKeys = srcKeys + count;
+    int* srcSlots = sortSlots.data();
+    int* dstSlots = srcSlots + count;
+
+    for (int i = 0; i < count; i++) {
+        srcKeys[i] = k[o[i]];
+        srcSlots[i] = o[i];
+    }
+
+    for (int shift = 0; shift < 16; shift += 8) {
+        int offsets[257] = {0};
+        for (int i = 0; i < count; i++)
+            offsets[((srcKeys[i] >> shift) & 0xff) + 1]++;
+        for (int b = 0; b < 256; b++)
+            offsets[b + 1] += offsets[b];
+
+        for (int i = 0; i < count; i++) {
+            int dst = offsets[(srcKeys[i] >> shift) & 0xff]++;
+            dstKeys[dst] = srcKeys[i];
+            dstSlots[dst] = srcSlots[i];
+        }
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcSlots, dstSlots);
+    }
+
+    memcpy(o, srcSlots, count * sizeof(int));
+}
+
+}
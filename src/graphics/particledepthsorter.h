@@ -0,0 +1,60 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PARTICLEDEPTHSORTER_H
+#define PARTICLEDEPTHSORTER_H
+
+#include <QVector>
+#include <QMatrix4x4>
+
+namespace iris
+{
+
+class ParticlePool;
+
+/**
+ * Orders a particle pool back to front for alpha blending.
+ * View depths are quantised to 16 bits and radix sorted. The previous
+ * frame's order is kept, and while the camera barely moves it's usually
+ * still almost sorted, so an insertion sort is tried on it first and the
+ * radix sort is only used if that has too much to fix.
+ */
+class ParticleDepthSorter
+{
+public:
+    // pool slots, farthest first
+    QVector<int> order;
+
+    ParticleDepthSorter();
+
+    void sort(const ParticlePool& particles, const QMatrix4x4& viewMatrix);
+
+    // forgets the previous order so the next sort starts from scratch
+    void reset();
+
+private:
+    void updateKeys(const ParticlePool& particles, const QMatrix4x4& viewMatrix);
+    bool insertionSort(int maxMoves);
+    void radixSort();
+
+    QVector<quint16> keys;
+    QVector<float> depths;
+    // radix sort buffers, each holds two halves the passes ping-pong between
+    QVector<quint16> sortKeys;
+    QVector<int> sortSlots;
+
+    QMatrix4x4 lastViewMatrix;
+    bool hasOrder;
+};
+
+}
+
+#endif // PARTICLEDEPTHSORTER_H
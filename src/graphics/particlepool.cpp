@@ -0,0 +1,177 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "particlepool.h"
+#include "../math/mathhelper.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PARTICLEPOOL_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace iris
+{
+
+ParticlePool::ParticlePool()
+{
+    count = 0;
+    capacity = 0;
+}
+
+void ParticlePool::setCapacity(int capacity)
+{
+    capacity = qMax(capacity, 0);
+
+    positionX.resize(capacity);
+    positionY.resize(capacity);
+    positionZ.resize(capacity);
+    velocityX.resize(capacity);
+    velocityY.resize(capacity);
+    velocityZ.resize(capacity);
+    gravityEffect.resize(capacity);
+    lifeLength.resize(capacity);
+    elapsedTime.resize(capacity);
+    rotation.resize(capacity);
+    scale.resize(capacity);
+
+    this->capacity = capacity;
+    count = qMin(count, capacity);
+}
+
+bool ParticlePool::emit(const QVector3D& position,
+                        const QVector3D& velocity,
+                        float gravityEffect,
+                        float lifeLength,
+                        float rotation,
+                        float scale)
+{
+    if (isFull())
+        return false;
+
+    int i = count++;
+    positionX[i] = position.x();
+    positionY[i] = position.y();
+    positionZ[i] = position.z();
+    velocityX[i] = velocity.x();
+    velocityY[i] = velocity.y();
+    velocityZ[i] = velocity.z();
+    this->gravityEffect[i] = gravityEffect;
+    this->lifeLength[i] = lifeLength;
+    elapsedTime[i] = 0;
+    this->rotation[i] = rotation;
+    this->scale[i] = scale;
+
+    return true;
+}
+
+void ParticlePool::remove(int index)
+{
+    int last = --count;
+    if (index == last)
+        return;
+
+    positionX[index] = positionX[last];
+    positionY[index] = positionY[last];
+    positionZ[index] = positionZ[last];
+    velocityX[index] = velocityX[last];
+    velocityY[index] = velocityY[last];
+    velocityZ[index] = velocityZ[last];
+    gravityEffect[index] = gravityEffect[last];
+    lifeLength[index] = lifeLength[last];
+    elapsedTime[index] = elapsedTime[last];
+    rotation[index] = rotation[last];
+    scale[index] = scale[last];
+}
+
+void ParticlePool::integrate(float delta, bool dissipate, bool inverseDissipate, float particleScale, int begin, int end)
+{
+    float* px = positionX.data();
+    float* py = positionY.data();
+    float* pz = positionZ.data();
+    const float* vx = velocityX.constData();
+    float* vy = velocityY.data();
+    const float* vz = velocityZ.constData();
+    const float* gravity = gravityEffect.constData();
+    const float* life = lifeLength.constData();
+    float* elapsed = elapsedTime.data();
+    float* scl = scale.data();
+
+    int i = begin;
+
+#ifdef PARTICLEPOOL_SSE
+    const __m128 delta4 = _mm_set1_ps(delta);
+    const __m128 gravity4 = _mm_set1_ps(PARTICLE_GRAVITY);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 particleScale4 = _mm_set1_ps(particleScale);
+
+    for (; i + 4 <= end; i += 4) {
+        // same operations in the same order as the scalar loop below
+        __m128 velY = _mm_add_ps(_mm_loadu_ps(vy + i),
+                                 _mm_mul_ps(_mm_mul_ps(gravity4, _mm_loadu_ps(gravity + i)), delta4));
+        _mm_storeu_ps(vy + i, velY);
+
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_loadu_ps(vx + i), delta4)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velY, delta4)));
+        _mm_storeu_ps(pz + i, _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(_mm_loadu_ps(vz + i), delta4)));
+
+        __m128 age = _mm_add_ps(_mm_loadu_ps(elapsed + i), delta4);
+        _mm_storeu_ps(elapsed + i, age);
+
+        if (dissipate) {
+            __m128 scale4 = _mm_loadu_ps(scl + i);
+            __m128 t = _mm_div_ps(age, _mm_loadu_ps(life + i));
+
+            __m128 newScale;
+            // MathHelper::lerp(t, 0, particleScale)
+            if (inverseDissipate)
+                newScale = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(particleScale4, zero), t), zero);
+            else
+                newScale = _mm_mul_ps(scale4, _mm_sub_ps(one, t));
+
+            __m128 started = _mm_cmpgt_ps(age, zero);
+            _mm_storeu_ps(scl + i, _mm_or_ps(_mm_and_ps(started, newScale), _mm_andnot_ps(started, scale4)));
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        vy[i] += PARTICLE_GRAVITY * gravity[i] * delta;
+
+        px[i] += vx[i] * delta;
+        py[i] += vy[i] * delta;
+        pz[i] += vz[i] * delta;
+
+        elapsed[i] += delta;
+
+        if (dissipate && elapsed[i] > 0) {
+            float t = elapsed[i] / life[i];
+            if (inverseDissipate)
+                scl[i] = MathHelper::lerp(t, 0, particleScale);
+            else
+                scl[i] *= 1.0f - t;
+        }
+    }
+}
+
+void ParticlePool::removeExpired()
+{
+    // a removed slot is filled from the end so it's checked again
+    int i = 0;
+    while (i < count) {
+        if (elapsedTime[i] > lifeLength[i])
+            remove(i);
+        else
+            i++;
+    }
+}
+
+}
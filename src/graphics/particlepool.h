@@ -0,0 +1,98 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef PARTICLEPOOL_H
+#define PARTICLEPOOL_H
+
+#include <QVector>
+#include <QVector3D>
+
+// scaled by each particle's gravityEffect
+#define PARTICLE_GRAVITY -50.0f
+
+namespace iris
+{
+
+/**
+ * Fixed capacity particle storage with one array per attribute.
+ * The live particles are always the first count slots, a dead particle is
+ * replaced by the last live one so emitting and expiring never allocate.
+ */
+class ParticlePool
+{
+public:
+    QVector<float> positionX, positionY, positionZ;
+    QVector<float> velocityX, velocityY, velocityZ;
+    QVector<float> gravityEffect;
+    QVector<float> lifeLength;
+    QVector<float> elapsedTime;
+    QVector<float> rotation;
+    QVector<float> scale;
+
+    int count;
+    int capacity;
+
+    ParticlePool();
+
+    // particles past the new capacity are dropped
+    void setCapacity(int capacity);
+
+    void clear()
+    {
+        count = 0;
+    }
+
+    bool isFull() const
+    {
+        return count >= capacity;
+    }
+
+    // returns false if the pool is full
+    bool emit(const QVector3D& position,
+              const QVector3D& velocity,
+              float gravityEffect,
+              float lifeLength,
+              float rotation,
+              float scale);
+
+    // moves the last particle into index
+    void remove(int index);
+
+    /*
+     * Applies gravity, moves and ages every particle by delta
+     * With dissipate the scale shrinks over the particle's life, or grows
+     * towards particleScale with inverseDissipate
+     */
+    void integrate(float delta, bool dissipate, bool inverseDissipate, float particleScale)
+    {
+        integrate(delta, dissipate, inverseDissipate, particleScale, 0, count);
+    }
+
+    // only particles in [begin, end), disjoint ranges can be integrated on different threads
+    void integrate(float delta, bool dissipate, bool inverseDissipate, float particleScale, int begin, int end);
+
+    // removes particles that have outlived their lifeLength
+    void removeExpired();
+
+    QVector3D getPosition(int index) const
+    {
+        return QVector3D(positionX[index], positionY[index], positionZ[index]);
+    }
+
+    float getLife(int index) const
+    {
+        return lifeLength[index] - elapsedTime[index];
+    }
+};
+
+}
+
+#endif // PARTICLEPOOL_H
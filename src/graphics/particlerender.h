@@ -17,13 +17,17 @@ For more information see the LICENSE file
 #include <QOpenGLFunctions_3_2_Core>
 #include <QOpenGLVersionFunctionsFactory>
 #include <QOpenGLContext>
-#include "particle.h"
+#include "particlepool.h"
+#include "particledepthsorter.h"
 #include "renderdata.h"
 #include "texture2d.h"
 #include "../core/irisutils.h"
 #include "graphicsdevice.h"
 #include "blendstate.h"
 
+// a_particle and a_particleParams
+#define PARTICLE_INSTANCE_FLOATS 8
+
 namespace iris {
 
 class ParticleRenderer {
@@ -34,8 +38,16 @@ private:
 	DepthState depthState;
 	iris::VertexBufferPtr vertexBuffer;
 
+    // per particle attributes for the instanced draw
+	iris::VertexBufferPtr instanceBuffer;
+    QVector<float> instanceData;
+
+    ParticleDepthSorter depthSorter;
+
 public:
     bool useAdditive;
+    // draws alpha blended particles back to front, additive ones don't need it
+    bool depthSort;
 
     QSharedPointer<iris::Texture2D> icon;
     ParticleRenderer() {
@@ -59,6 +71,13 @@ public:
 		vertexBuffer = iris::VertexBuffer::create(layout);
 		vertexBuffer->setData(quadVertices, sizeof(float) * 4 * 5);
 
+		VertexLayout instanceLayout;
+		instanceLayout.addAttrib(iris::VertexAttribUsage::InstanceParticle, GL_FLOAT, 4, sizeof(float) * 4, 1);
+		instanceLayout.addAttrib(iris::VertexAttribUsage::InstanceParticleParams, GL_FLOAT, 4, sizeof(float) * 4, 1);
+
+		instanceBuffer = iris::VertexBuffer::create(instanceLayout);
+		instanceBuffer->usage = GL_STREAM_DRAW;
+
 		/*
         gl->glGenVertexArrays(1, &quadVAO);
         gl->glGenBuffers(1, &quadVBO);
@@ -74,55 +93,97 @@ public:
         gl->glBindVertexArray(0);
 		*/
         useAdditive = true;
+        depthSort = false;
 		depthState = DepthState(true, false);
     }
 
-    void updateModelViewMatrix(GraphicsDevicePtr device,
-							   ShaderPtr shader,
-                               QVector3D pos,
-                               float rot,
-                               float scale,
-                               QMatrix4x4 viewMatrix)
-    {
-        QMatrix4x4 modelMatrix;
-        modelMatrix.translate(pos);
+    void setIcon(QSharedPointer<iris::Texture2D> icon) {
+        this->icon = icon;
+    }
 
-        modelMatrix(0, 0) = viewMatrix(0, 0);
-        modelMatrix(0, 1) = viewMatrix(1, 0);
-        modelMatrix(0, 2) = viewMatrix(2, 0);
+    void render(GraphicsDevicePtr device,
+				ShaderPtr shader,
+                iris::RenderData* renderData,
+                const ParticlePool& particles)
+    {
+        if (particles.count == 0)
+            return;
 
-        modelMatrix(1, 0) = viewMatrix(0, 1);
-        modelMatrix(1, 1) = viewMatrix(1, 1);
-        modelMatrix(1, 2) = viewMatrix(2, 1);
+        beginRender(device, shader, renderData);
 
-        modelMatrix(2, 0) = viewMatrix(0, 2);
-        modelMatrix(2, 1) = viewMatrix(1, 2);
-        modelMatrix(2, 2) = viewMatrix(2, 2);
+        const int* order = nullptr;
+        if (depthSort && !useAdditive) {
+            depthSorter.sort(particles, renderData->viewMatrix);
+            order = depthSorter.order.constData();
+        }
 
-        modelMatrix.rotate((float) rot, QVector3D(0, 0, 1));
-        modelMatrix.scale(scale, scale, scale);
+        // the quads are billboarded in particle.vert
+        if (!device->supportsInstancing()) {
+            device->setVertexBuffer(vertexBuffer);
+            for (int n = 0; n < particles.count; n++) {
+                int i = order ? order[n] : n;
+                // arrays are disabled outside of the draw so these constant values are used
+                gl->glVertexAttrib4f((GLuint)VertexAttribUsage::InstanceParticle,
+                                     particles.positionX[i],
+                                     particles.positionY[i],
+                                     particles.positionZ[i],
+                                     particles.scale[i]);
+                gl->glVertexAttrib4f((GLuint)VertexAttribUsage::InstanceParticleParams,
+                                     particles.rotation[i],
+                                     particles.elapsedTime[i] / particles.lifeLength[i],
+                                     0, 0);
+                device->drawPrimitives(GL_TRIANGLE_STRIP, 0, 4);
+            }
+            return;
+        }
 
-        QMatrix4x4 modelViewMatrix = viewMatrix * modelMatrix;
-		//shader->setUniformValue("modelViewMatrix", modelViewMatrix);
-		device->setShaderUniform("modelViewMatrix", modelViewMatrix);
-    }
+        // refilled every frame, uploading respecifies the whole buffer
+        instanceData.resize(particles.count * PARTICLE_INSTANCE_FLOATS);
+        float* instance = instanceData.data();
+        for (int n = 0; n < particles.count; n++) {
+            int i = order ? order[n] : n;
+            instance[0] = particles.positionX[i];
+            instance[1] = particles.positionY[i];
+            instance[2] = particles.positionZ[i];
+            instance[3] = particles.scale[i];
+            instance[4] = particles.rotation[i];
+            instance[5] = particles.elapsedTime[i] / particles.lifeLength[i];
+            instance[6] = 0;
+            instance[7] = 0;
+            instance += PARTICLE_INSTANCE_FLOATS;
+        }
+        instanceBuffer->setData(instanceData.data(), instanceData.size() * sizeof(float));
 
-    void setIcon(QSharedPointer<iris::Texture2D> icon) {
-        this->icon = icon;
+        device->setVertexBuffers({vertexBuffer, instanceBuffer});
+        device->drawPrimitivesInstanced(GL_TRIANGLE_STRIP, 0, 4, particles.count);
     }
 
+    /*
+     * Draws every slot of a GpuParticleSimulator's buffer, free slots have
+     * no size. The particles never reach the cpu so they aren't depth sorted
+     */
     void render(GraphicsDevicePtr device,
 				ShaderPtr shader,
                 iris::RenderData* renderData,
-                std::vector<Particle*>& particles)
+                VertexBufferPtr particleBuffer,
+                int capacity)
+    {
+        if (capacity == 0)
+            return;
+
+        beginRender(device, shader, renderData);
+
+        device->setVertexBuffers({vertexBuffer, particleBuffer});
+        device->drawPrimitivesInstanced(GL_TRIANGLE_STRIP, 0, 4, capacity);
+    }
+
+private:
+    void beginRender(GraphicsDevicePtr device, ShaderPtr shader, iris::RenderData* renderData)
     {
 		device->setShader(shader, true);
 
 		device->setShaderUniform("projectionMatrix", renderData->projMatrix);
-        QMatrix4x4 viewMatrix = renderData->viewMatrix;
-
-        //gl->glBindVertexArray(quadVAO);
-		
+		device->setShaderUniform("viewMatrix", renderData->viewMatrix);
 
         if (useAdditive) {
             device->setBlendState(BlendState(GL_SRC_ALPHA, GL_ONE), true);
@@ -131,29 +192,11 @@ public:
         }
 
 		device->setDepthState(depthState, true);
-		device->setVertexBuffer(vertexBuffer);
-
-        for (auto particle : particles) {
-            updateModelViewMatrix(
-						device,
-                        shader,
-                        particle->getPosition(),
-                        particle->getRotation(),
-                        particle->getScale(),
-                        viewMatrix
-                    );
-
-            if (!!icon) {
-                gl->glActiveTexture(GL_TEXTURE0);
-                icon->texture->bind();
-            }
-            //gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			
-			device->drawPrimitives(GL_TRIANGLE_STRIP, 0, 4);
-        }
-
-        //gl->glBindVertexArray(0);
 
+        if (!!icon) {
+            gl->glActiveTexture(GL_TEXTURE0);
+            icon->texture->bind();
+        }
     }
 };
 
@@ -37,6 +37,19 @@ struct RasterizerState
 		depthBias = 0;
     }
 
+    bool operator==(const RasterizerState& other) const
+    {
+        return cullMode == other.cullMode &&
+               fillMode == other.fillMode &&
+               depthScaleBias == other.depthScaleBias &&
+               depthBias == other.depthBias;
+    }
+
+    bool operator!=(const RasterizerState& other) const
+    {
+        return !(*this == other);
+    }
+
     static RasterizerState CullCounterClockwise;
     static RasterizerState CullClockwise;
     static RasterizerState CullNone;
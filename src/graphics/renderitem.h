@@ -50,10 +50,17 @@ struct RenderItem
     bool physicsObject = false;
     BoundingSphere boundingSphere;
 
+    // set by the renderer's culling pass to the stamp of the last pass
+    // in which this item was found inside the view frustum
+    unsigned int cullStamp = 0;
+
     //sort order for render layer
     //used if no material is specified
     int renderLayer;
 
+    // built by RenderList::sort, see RenderList::buildSortKey
+    quint64 sortKey = 0;
+
     RenderItem() {
         type = RenderItemType::None;
         worldMatrix.setToIdentity();
@@ -1,18 +1,21 @@
 #include "renderlist.h"
 #include "renderitem.h"
 #include "model.h"
+#include "shader.h"
+#include <QVector3D>
+#include <QHash>
+#include <cstring>
 #include <algorithm>
 
 namespace iris {
 
 RenderList::RenderList()
 {
-    used.reserve(1000);
-    pool.reserve(1000);
+    renderList.reserve(RENDERLIST_BLOCK_SIZE);
+    blocks.append(new RenderItem[RENDERLIST_BLOCK_SIZE]);
+    allocatedItems = 0;
 
-    // todo: check how slow this is
-    for(int i = 0;i<1000; i++)
-        pool.append(new RenderItem());
+    sortStats = RenderListSortStats();
 }
 
 void RenderList::add(RenderItem *item)
@@ -20,16 +23,27 @@ void RenderList::add(RenderItem *item)
     renderList.append(item);
 }
 
-RenderItem *RenderList::submitMesh(MeshPtr mesh, MaterialPtr mat, QMatrix4x4 worldMatrix)
+void RenderList::addItems(const RenderList& other)
 {
-    RenderItem* item;
-    if (pool.size()>0) {
-        item = pool.takeFirst();
-    } else {
-        item = new RenderItem();
-    }
+    renderList.append(other.renderList);
+}
+
+RenderItem* RenderList::allocateItem()
+{
+    int blockIndex = allocatedItems / RENDERLIST_BLOCK_SIZE;
+    if (blockIndex == blocks.size())
+        blocks.append(new RenderItem[RENDERLIST_BLOCK_SIZE]);
+
+    auto item = &blocks[blockIndex][allocatedItems % RENDERLIST_BLOCK_SIZE];
+    allocatedItems++;
+
     item->reset();
-    used.push_back(item);
+    return item;
+}
+
+RenderItem *RenderList::submitMesh(const MeshPtr& mesh, const MaterialPtr& mat, const QMatrix4x4& worldMatrix)
+{
+    auto item = allocateItem();
 
     item->type = RenderItemType::Mesh;
     item->mesh = mesh;
@@ -42,16 +56,9 @@ RenderItem *RenderList::submitMesh(MeshPtr mesh, MaterialPtr mat, QMatrix4x4 wor
 	return item;
 }
 
-RenderItem *RenderList::submitMesh(MeshPtr mesh, QOpenGLShaderProgram *shader, QMatrix4x4 worldMatrix, int renderLayer)
+RenderItem *RenderList::submitMesh(const MeshPtr& mesh, QOpenGLShaderProgram *shader, const QMatrix4x4& worldMatrix, int renderLayer)
 {
-    RenderItem* item;
-    if (pool.size()>0) {
-        item = pool.takeFirst();
-    } else {
-        item = new RenderItem();
-    }
-    item->reset();
-    used.push_back(item);
+    auto item = allocateItem();
 
     item->type = RenderItemType::Mesh;
     item->mesh = mesh;
@@ -62,40 +69,147 @@ RenderItem *RenderList::submitMesh(MeshPtr mesh, QOpenGLShaderProgram *shader, Q
 	return item;
 }
 
-void RenderList::submitModel(ModelPtr model, MaterialPtr mat, QMatrix4x4 worldMatrix)
+void RenderList::submitModel(const ModelPtr& model, const MaterialPtr& mat, const QMatrix4x4& worldMatrix)
 {
-	for (auto modelMesh : model->modelMeshes) {
+	for (auto& modelMesh : model->modelMeshes) {
 		submitMesh(modelMesh.mesh, mat, worldMatrix);
 	}
 }
 
-void RenderList::submitModel(ModelPtr model, QMatrix4x4 worldMatrix)
+void RenderList::submitModel(const ModelPtr& model, const QMatrix4x4& worldMatrix)
 {
-	for (auto modelMesh : model->modelMeshes) {
+	for (auto& modelMesh : model->modelMeshes) {
 		submitMesh(modelMesh.mesh, modelMesh.material, worldMatrix);
 	}
 }
 
 void RenderList::clear()
 {
+    // qt keeps the capacity when clearing an unshared vector
     renderList.clear();
-
-    for(auto item : used)
-        pool.append(item);
-    used.clear();
+    allocatedItems = 0;
 }
 
 void RenderList::sort()
 {
+    sortItems(QVector3D(), false);
+}
 
-    std::sort(renderList.begin(), renderList.end(), [](const RenderItem* a, const RenderItem* b) {
-        return a->renderLayer < b->renderLayer;
-    });
+void RenderList::sort(const QVector3D& eyePos)
+{
+    sortItems(eyePos, true);
 }
 
-RenderList::~RenderList()
+void RenderList::sortItems(const QVector3D& eyePos, bool sortByDepth)
 {
+    countStateChanges(renderList, sortStats.shaderChangesBefore, sortStats.materialChangesBefore);
+
+    for (auto item : renderList)
+        item->sortKey = buildSortKey(item, eyePos, sortByDepth);
+
+    // lsd radix sort on 8 bits at a time, the sort is stable so items with
+    // equal keys are drawn in the order they were submitted
+    auto count = renderList.size();
+    sortBuffer.resize(count);
+
+    RenderItem** src = renderList.data();
+    RenderItem** dest = sortBuffer.data();
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256];
+        memset(offsets, 0, sizeof(offsets));
+
+        for (int i = 0; i < count; i++)
+            offsets[(src[i]->sortKey >> shift) & 0xFF]++;
+
+        // every key shares this byte, nothing to do for this pass
+        if (count == 0 || offsets[(src[0]->sortKey >> shift) & 0xFF] == count)
+            continue;
+
+        int total = 0;
+        for (int i = 0; i < 256; i++) {
+            int bucketSize = offsets[i];
+            offsets[i] = total;
+            total += bucketSize;
+        }
 
+        for (int i = 0; i < count; i++)
+            dest[offsets[(src[i]->sortKey >> shift) & 0xFF]++] = src[i];
+
+        std::swap(src, dest);
+    }
+
+    // an odd number of passes leaves the result in the scratch buffer
+    if (src != renderList.data())
+        renderList.swap(sortBuffer);
+
+    countStateChanges(renderList, sortStats.shaderChangesAfter, sortStats.materialChangesAfter);
+}
+
+/*
+ * Key layout from the most significant bit:
+ * opaque       layer(16) shader(12) material(12) mesh(8) depth(16)
+ * transparent  layer(16) inverted depth(16) shader(12) material(12) mesh(8)
+ *
+ * Depth is the top 16 bits of the squared distance's float representation which
+ * keeps the ordering of positive floats without needing the camera's far plane
+ */
+quint64 RenderList::buildSortKey(RenderItem* item, const QVector3D& eyePos, bool sortByDepth)
+{
+    quint64 layer = qBound(0, item->renderLayer, 0xFFFF);
+
+    quint64 shaderId = 0;
+    quint64 materialId = 0;
+    if (!!item->material) {
+        if (!!item->material->shader)
+            shaderId = item->material->shader->getShaderId() & 0xFFF;
+        materialId = qHash(item->material.data()) & 0xFFF;
+    } else if (item->shaderProgram) {
+        shaderId = qHash(item->shaderProgram) & 0xFFF;
+    }
+
+    quint64 meshId = !!item->mesh ? qHash(item->mesh.data()) & 0xFF : 0;
+    quint64 state = (shaderId << 20) | (materialId << 8) | meshId;
+
+    quint64 depth = 0;
+    if (sortByDepth) {
+        float distSqrd = (item->worldMatrix.column(3).toVector3D() - eyePos).lengthSquared();
+        quint32 bits;
+        memcpy(&bits, &distSqrd, sizeof(float));
+        depth = bits >> 16;
+    }
+
+    if (item->renderLayer >= (int)RenderLayer::Transparent && item->renderLayer < (int)RenderLayer::Overlay)
+        return (layer << 48) | ((0xFFFF - depth) << 32) | state;
+
+    return (layer << 48) | (state << 16) | depth;
+}
+
+void RenderList::countStateChanges(const QVector<RenderItem*>& items, int& shaderChanges, int& materialChanges)
+{
+    shaderChanges = 0;
+    materialChanges = 0;
+
+    Shader* lastShader = nullptr;
+    Material* lastMaterial = nullptr;
+    for (auto item : items) {
+        auto material = item->material.data();
+        auto shader = !!item->material ? item->material->shader.data() : nullptr;
+
+        if (shader != lastShader)
+            shaderChanges++;
+        if (material != lastMaterial)
+            materialChanges++;
+
+        lastShader = shader;
+        lastMaterial = material;
+    }
+}
+
+RenderList::~RenderList()
+{
+    for (auto block : blocks)
+        delete[] block;
 }
 
 
@@ -8,35 +8,78 @@ namespace iris {
 
 class RenderItem;
 
+/**
+ * Number of times the shader or material changes between consecutive items,
+ * counted in submission order and again after sorting
+ */
+struct RenderListSortStats
+{
+    int shaderChangesBefore;
+    int materialChangesBefore;
+    int shaderChangesAfter;
+    int materialChangesAfter;
+};
+
+#define RENDERLIST_BLOCK_SIZE 1024
+
 class RenderList
 {
-    QVector<RenderItem*> pool;
-    QVector<RenderItem*> used;
+    // owns the blocks, a copy would free them twice
+    Q_DISABLE_COPY(RenderList)
+
+    // items handed out by submitMesh live in fixed size blocks that are kept
+    // across frames, clear() just rewinds allocatedItems
+    QVector<RenderItem*> blocks;
+    int allocatedItems;
 
     QVector<RenderItem*> renderList;
+
+    // scratch space for the radix sort, kept around to avoid reallocating every frame
+    QVector<RenderItem*> sortBuffer;
+
+    RenderListSortStats sortStats;
 public:
     RenderList();
-//    QVector<RenderItem*>& getItems();
-    QVector<RenderItem*> getItems()
+    const QVector<RenderItem*>& getItems() const
     {
         return renderList;
     }
 
     void add(RenderItem* item);
 
-    RenderItem* submitMesh(MeshPtr mesh, MaterialPtr mat, QMatrix4x4 worldMatrix);
+    // appends the items of another list in order, the other list keeps ownership
+    void addItems(const RenderList& other);
+
+    RenderItem* submitMesh(const MeshPtr& mesh, const MaterialPtr& mat, const QMatrix4x4& worldMatrix);
 
-    RenderItem* submitMesh(MeshPtr mesh, QOpenGLShaderProgram* shader, QMatrix4x4 worldTransform, int renderLayer = (int)RenderLayer::Opaque);
+    RenderItem* submitMesh(const MeshPtr& mesh, QOpenGLShaderProgram* shader, const QMatrix4x4& worldTransform, int renderLayer = (int)RenderLayer::Opaque);
 
-	void submitModel(ModelPtr model, MaterialPtr mat, QMatrix4x4 worldMatrix);
+	void submitModel(const ModelPtr& model, const MaterialPtr& mat, const QMatrix4x4& worldMatrix);
 
-	void submitModel(ModelPtr model, QMatrix4x4 worldMatrix);
+	void submitModel(const ModelPtr& model, const QMatrix4x4& worldMatrix);
 
     void clear();
 
+    /**
+     * Sorts items by render layer then by shader, material and mesh to minimize state changes
+     * If an eye position is given then opaque items are also sorted front-to-back and
+     * transparent items back-to-front
+     */
     void sort();
+    void sort(const QVector3D& eyePos);
+
+    RenderListSortStats getSortStats()
+    {
+        return sortStats;
+    }
 
     ~RenderList();
+
+private:
+    RenderItem* allocateItem();
+    void sortItems(const QVector3D& eyePos, bool sortByDepth);
+    static quint64 buildSortKey(RenderItem* item, const QVector3D& eyePos, bool sortByDepth);
+    static void countStateChanges(const QVector<RenderItem*>& items, int& shaderChanges, int& materialChanges);
 };
 
 }
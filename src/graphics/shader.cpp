@@ -44,6 +44,8 @@ Shader::~Shader()
 void Shader::setVertexShader(QString vertexShader)
 {
 	this->vertexShader = vertexShader;
+	// checked per render item when batching, so it's only searched for here
+	hasInstancingPath = vertexShader.contains("INSTANCING_ENABLED");
 	_setDirty();
 }
 
@@ -53,6 +55,12 @@ void Shader::setFragmentShader(QString fragmentShader)
 	_setDirty();
 }
 
+void Shader::setTransformFeedbackVaryings(const QStringList& varyings)
+{
+	feedbackVaryings = varyings;
+	_setDirty();
+}
+
 bool Shader::isFlagEnabled(QString flag)
 {
 	return flags.contains(flag);
@@ -94,8 +102,10 @@ ShaderPtr Shader::create()
 Shader::Shader()
 {
 	isDirty = true;
+	hasInstancingPath = false;
 	program = nullptr;
 	hasErrors = false;
+	uniformBlockMask = 0;
 
     shaderId = generateNodeId();
 }
@@ -113,11 +123,63 @@ ShaderValue* Shader::getUniform(QString name)
     return nullptr;
 }
 
+int Shader::getUniformHandle(const QByteArray& name)
+{
+	auto iter = uniformHandles.constFind(name);
+	if (iter != uniformHandles.constEnd())
+		return iter.value();
+
+	// callers may pass a QByteArray::fromRawData wrapper around a temporary,
+	// the interned key has to own its data
+	QByteArray owned(name.constData(), name.size());
+
+	int handle = uniformHandleNames.size();
+	uniformHandleNames.append(owned);
+	uniformHandles.insert(owned, handle);
+	return handle;
+}
+
+int Shader::getUniformLocation(int handle)
+{
+	if (handle >= uniformLocations.size())
+		uniformLocations.resize(uniformHandleNames.size(), -2);
+
+	int location = uniformLocations[handle];
+	if (location == -2) {
+		// uniforms that dont exist are cached as -1 so they're only looked up once
+		location = program != nullptr ? program->uniformLocation(uniformHandleNames[handle].constData()) : -1;
+		uniformLocations[handle] = location;
+	}
+
+	return location;
+}
+
+int Shader::getUniformLocation(const QByteArray& name)
+{
+	return getUniformLocation(getUniformHandle(name));
+}
+
+void Shader::clearUniformLocations()
+{
+	uniformLocations.clear();
+	uniformBlockMask = 0;
+}
+
+void Shader::cacheUniformLocation(const QByteArray& name, int location)
+{
+	int handle = getUniformHandle(name);
+	if (handle >= uniformLocations.size())
+		uniformLocations.resize(uniformHandleNames.size(), -2);
+	uniformLocations[handle] = location;
+}
+
 long Shader::generateNodeId()
 {
     return nextId++;
 }
 
 long Shader::nextId = 0;
+QHash<QByteArray, int> Shader::uniformHandles;
+QList<QByteArray> Shader::uniformHandleNames;
 
 }
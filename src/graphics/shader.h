@@ -16,6 +16,9 @@ For more information see the LICENSE file
 #include <QVariant>
 #include <qopengl.h>
 #include <QSet>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
 
 class QOpenGLShaderProgram;
 class QOpenGLFunctions_3_2_Core;
@@ -79,12 +82,44 @@ public:
 	void setVertexShader(QString vertexShader);
 	void setFragmentShader(QString fragmentShader);
 
+	/*
+	 * Vertex shader outputs written to the bound buffer, in order, between
+	 * GraphicsDevice::beginTransformFeedback and endTransformFeedback
+	 */
+	void setTransformFeedbackVaryings(const QStringList& varyings);
+
 	bool isFlagEnabled(QString flag);
 	void enableFlag(QString flag);
 	void disableFlag(QString flag);
 
 	void _setDirty();
 
+	// true if the vertex shader has an INSTANCING_ENABLED path
+	bool supportsInstancing()
+	{
+		return hasInstancingPath;
+	}
+
+	long getShaderId()
+	{
+		return shaderId;
+	}
+
+	/*
+	 * Uniform names are registered once globally and referred to by integer handles
+	 * afterwards. Each shader resolves the location of a handle the first time it's
+	 * used and caches it until the shader is recompiled.
+	 */
+	static int getUniformHandle(const QByteArray& name);
+	int getUniformLocation(int handle);
+	int getUniformLocation(const QByteArray& name);
+
+	// true if the shader declares the uniform block assigned to this binding point
+	bool usesUniformBlock(int bindingPoint)
+	{
+		return (uniformBlockMask & (1u << bindingPoint)) != 0;
+	}
+
 private:
 	QOpenGLShaderProgram * program;
 	long shaderId;
@@ -118,6 +153,16 @@ private:
     static long generateNodeId();
     static long nextId;
 
+	void clearUniformLocations();
+	void cacheUniformLocation(const QByteArray& name, int location);
+
+	// locations indexed by uniform handle, -2 means it hasnt been resolved yet
+	QVector<int> uniformLocations;
+	unsigned int uniformBlockMask;
+
+	static QHash<QByteArray, int> uniformHandles;
+	static QList<QByteArray> uniformHandleNames;
+
 protected:
     QMap<QString,ShaderValue*> attribs;
     QMap<QString,ShaderValue*> uniforms;
@@ -126,6 +171,8 @@ protected:
     QList<ShaderValue*> updatedUniforms;
 
 	QString vertexShader, fragmentShader;
+	bool hasInstancingPath;
+	QStringList feedbackVaryings;
 	QSet<QString> flags;
 	bool hasErrors;
 };
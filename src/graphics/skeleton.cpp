@@ -71,7 +71,7 @@ void Skeleton::applyAnimation(iris::SkeletalAnimationPtr anim, float time)
 }
 
 // https://github.com/acgessler/open3mod/blob/master/open3mod/SceneAnimator.cs#L338
-void Skeleton::applyAnimation(QMatrix4x4 inverseMeshMatrix, QMap<QString, QMatrix4x4> skeletonSpaceMatrices)
+void Skeleton::applyAnimation(const QMatrix4x4& inverseMeshMatrix, const QMap<QString, QMatrix4x4>& skeletonSpaceMatrices)
 {
     for (auto i = 0; i < bones.size(); i++) {
         auto bone = bones[i];
@@ -88,6 +88,27 @@ void Skeleton::applyAnimation(QMatrix4x4 inverseMeshMatrix, QMap<QString, QMatri
         }
         boneTransforms[i] = bone->skinMatrix;
     }
+
+    poseVersion++;
+}
+
+void Skeleton::applyAnimation(const QMatrix4x4& inverseMeshMatrix,
+                              const QVector<QMatrix4x4>& skeletonSpaceMatrices,
+                              const QVector<int>& boneNodeIndices)
+{
+    Q_ASSERT(boneNodeIndices.size() == bones.size());
+
+    for (auto i = 0; i < bones.size(); i++) {
+        auto bone = bones[i].data();
+        int nodeIndex = boneNodeIndices[i];
+        if (nodeIndex != -1)
+            bone->skinMatrix = inverseMeshMatrix * skeletonSpaceMatrices[nodeIndex] * bone->inverseMeshSpacePoseMatrix;
+        else
+            bone->skinMatrix.setToIdentity();
+        boneTransforms[i] = bone->skinMatrix;
+    }
+
+    poseVersion++;
 }
 
 }
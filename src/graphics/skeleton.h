@@ -61,7 +61,10 @@ public:
 
 class Skeleton
 {
-    Skeleton(){}
+    Skeleton()
+    {
+        poseVersion = 0;
+    }
 public:
     QMap<QString, int> boneMap;
     QList<BonePtr> bones;
@@ -69,6 +72,9 @@ public:
     BonePtr getBone(QString name);
     QVector<QMatrix4x4> boneTransforms;
 
+    // bumped every time boneTransforms is written
+    unsigned int poseVersion;
+
     void addBone(BonePtr bone)
     {
         bones.append(bone);
@@ -98,7 +104,12 @@ public:
 
     void applyAnimation(SkeletalAnimationPtr anim, float time);
 
-    void applyAnimation(QMatrix4x4 inverseMeshMatrix, QMap<QString, QMatrix4x4> skeletonSpaceMatrices);
+    void applyAnimation(const QMatrix4x4& inverseMeshMatrix, const QMap<QString, QMatrix4x4>& skeletonSpaceMatrices);
+
+    // boneNodeIndices maps each bone to its entry in skeletonSpaceMatrices, -1 for none
+    void applyAnimation(const QMatrix4x4& inverseMeshMatrix,
+                        const QVector<QMatrix4x4>& skeletonSpaceMatrices,
+                        const QVector<int>& boneNodeIndices);
 
     static SkeletonPtr create()
     {
@@ -0,0 +1,87 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "skinning.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SKINNING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace iris
+{
+
+void skinPositions(const SkinData& skin,
+                   const QVector<QMatrix4x4>& boneTransforms,
+                   QVector<QVector3D>& positions)
+{
+    int vertexCount = skin.getVertexCount();
+    int boneCount = boneTransforms.size();
+    positions.resize(vertexCount);
+
+    const float* bindPositions = reinterpret_cast<const float*>(skin.positions.constData());
+    const int* indices = skin.boneIndices.constData();
+    const float* weights = skin.boneWeights.constData();
+    const QMatrix4x4* bones = boneTransforms.constData();
+
+    for (int v = 0; v < vertexCount; v++) {
+        const float* p = bindPositions + v * 4;
+        const int* vertexIndices = indices + v * SKIN_MAX_BONE_INDICES;
+        const float* vertexWeights = weights + v * SKIN_MAX_BONE_INDICES;
+
+#ifdef SKINNING_SSE
+        // columns of the blended matrix
+        __m128 c0 = _mm_setzero_ps();
+        __m128 c1 = _mm_setzero_ps();
+        __m128 c2 = _mm_setzero_ps();
+        __m128 c3 = _mm_setzero_ps();
+
+        for (int k = 0; k < SKIN_MAX_BONE_INDICES; k++) {
+            int bone = vertexIndices[k];
+            if (vertexWeights[k] == 0.0f || bone < 0 || bone >= boneCount)
+                continue;
+
+            const float* m = bones[bone].constData();
+            __m128 w = _mm_set1_ps(vertexWeights[k]);
+            c0 = _mm_add_ps(c0, _mm_mul_ps(_mm_loadu_ps(m), w));
+            c1 = _mm_add_ps(c1, _mm_mul_ps(_mm_loadu_ps(m + 4), w));
+            c2 = _mm_add_ps(c2, _mm_mul_ps(_mm_loadu_ps(m + 8), w));
+            c3 = _mm_add_ps(c3, _mm_mul_ps(_mm_loadu_ps(m + 12), w));
+        }
+
+        __m128 r = _mm_mul_ps(c0, _mm_set1_ps(p[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(p[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(p[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(p[3])));
+
+        float result[4];
+        _mm_storeu_ps(result, r);
+        positions[v] = QVector3D(result[0], result[1], result[2]);
+#else
+        float m[16] = {0};
+        for (int k = 0; k < SKIN_MAX_BONE_INDICES; k++) {
+            int bone = vertexIndices[k];
+            if (vertexWeights[k] == 0.0f || bone < 0 || bone >= boneCount)
+                continue;
+
+            const float* b = bones[bone].constData();
+            for (int i = 0; i < 16; i++)
+                m[i] += b[i] * vertexWeights[k];
+        }
+
+        positions[v] = QVector3D(m[0] * p[0] + m[4] * p[1] + m[8]  * p[2] + m[12] * p[3],
+                                 m[1] * p[0] + m[5] * p[1] + m[9]  * p[2] + m[13] * p[3],
+                                 m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14] * p[3]);
+#endif
+    }
+}
+
+}
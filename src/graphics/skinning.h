@@ -0,0 +1,59 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+#include <QMatrix4x4>
+
+// bone influences per vertex, matches the a_boneIndices and a_boneWeights attributes
+#define SKIN_MAX_BONE_INDICES 4
+
+namespace iris
+{
+
+/**
+ * Copy of a skinned mesh's vertex data kept on the cpu so it can be posed
+ * without the gpu, for bounds, picking and headless rendering.
+ */
+struct SkinData
+{
+    // bind pose positions with w set to 1
+    QVector<QVector4D> positions;
+
+    // SKIN_MAX_BONE_INDICES per vertex, unused slots have a weight of 0
+    QVector<int> boneIndices;
+    QVector<float> boneWeights;
+
+    // three per triangle
+    QVector<unsigned int> indices;
+
+    int getVertexCount() const
+    {
+        return positions.size();
+    }
+};
+
+/*
+ * Poses every vertex with boneTransforms the same way the skinning shader does,
+ * each position is transformed by the weighted sum of its bones' matrices.
+ * Results are in mesh space
+ */
+void skinPositions(const SkinData& skin,
+                   const QVector<QMatrix4x4>& boneTransforms,
+                   QVector<QVector3D>& positions);
+
+}
+
+#endif // SKINNING_H
@@ -0,0 +1,106 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef UNIFORMBLOCKS_H
+#define UNIFORMBLOCKS_H
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QColor>
+#include <cstring>
+
+namespace iris
+{
+
+/*
+ * CPU side copies of the blocks declared in assets/shaders/uniform_blocks.glsl
+ * The layouts follow std140 so any change here must be mirrored in the shader
+ */
+
+#define UNIFORM_BLOCK_MAX_LIGHTS 8
+
+enum class UniformBlockBinding
+{
+    Camera = 0,
+    Fog = 1,
+    Lights = 2
+};
+
+struct CameraBlock
+{
+    float viewMatrix[16];
+    float projMatrix[16];
+    float eyePos[3];
+    float time;
+    float sceneAmbient[3];
+    float _pad0;
+};
+
+struct FogBlock
+{
+    float color[4];
+    float start;
+    float end;
+    float _pad0[2];
+};
+
+struct LightBlock
+{
+    float color[4];
+    float shadowColor[4];
+    float position[3];
+    int type;
+    float direction[3];
+    float distance;
+    float intensity;
+    float cutOffAngle;
+    float cutOffSoftness;
+    float shadowAlpha;
+    float shadowMatrix[16];
+    int shadowType;
+    int _pad0[3];
+};
+
+struct LightsBlock
+{
+    LightBlock lights[UNIFORM_BLOCK_MAX_LIGHTS];
+    int lightCount;
+    int _pad0[3];
+};
+
+static_assert(sizeof(CameraBlock) == 160, "CameraBlock doesnt match std140 layout");
+static_assert(sizeof(FogBlock) == 32, "FogBlock doesnt match std140 layout");
+static_assert(sizeof(LightBlock) == 160, "LightBlock doesnt match std140 layout");
+
+inline void copyToBlock(float* dest, const QMatrix4x4& mat)
+{
+    // both QMatrix4x4 and glsl store matrices in column-major order
+    memcpy(dest, mat.constData(), sizeof(float) * 16);
+}
+
+inline void copyToBlock(float* dest, const QVector3D& vec)
+{
+    dest[0] = vec.x();
+    dest[1] = vec.y();
+    dest[2] = vec.z();
+}
+
+inline void copyToBlock(float* dest, const QColor& col)
+{
+    dest[0] = col.redF();
+    dest[1] = col.greenF();
+    dest[2] = col.blueF();
+    dest[3] = col.alphaF();
+}
+
+}
+
+#endif // UNIFORMBLOCKS_H
@@ -27,9 +27,9 @@ QList<VertexAttribute> VertexLayout::getAttribs()
 	return attribs;
 }
 
-void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeOfAttribInBytes)
+void VertexLayout::addAttrib(VertexAttribUsage usage,int type,int count,int sizeOfAttribInBytes,int divisor)
 {
-    VertexAttribute attrib = {usage, type, count, sizeOfAttribInBytes};
+    VertexAttribute attrib = {usage, type, count, sizeOfAttribInBytes, divisor};
     attribs.append(attrib);
 
     stride += sizeOfAttribInBytes;
@@ -40,26 +40,52 @@ int VertexLayout::getStride()
     return stride;
 }
 
+bool VertexLayout::isInstanced()
+{
+    for(auto& attrib: attribs)
+        if (attrib.divisor != 0)
+            return true;
+    return false;
+}
+
 // https://stackoverflow.com/a/30106751
 #define BUFFER_OFFSET(i) ((char*)nullptr+(i))
 
-void VertexLayout::bind(QOpenGLFunctions_3_2_Core* gl)
+void VertexLayout::bind(QOpenGLFunctions_3_2_Core* gl, VertexAttribDivisorFunc divisorFunc)
 {
     int offset = 0;
     for(auto attrib: attribs)
     {
-        //gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type, GL_FALSE, stride, (void*)offset);
-        gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type, GL_FALSE, stride, BUFFER_OFFSET(offset));
-        gl->glEnableVertexAttribArray((int)attrib.usage);
+        // matrices are passed as one vec4 per column in consecutive locations
+        int columns = attrib.count > 4 ? attrib.count / 4 : 1;
+        int columnCount = attrib.count / columns;
+        int columnSize = attrib.sizeInBytes / columns;
+
+        for (int i = 0; i < columns; i++) {
+            GLuint location = (GLuint)attrib.usage + i;
+            //gl->glVertexAttribPointer((GLuint)attrib.usage, attrib.count, (GLenum)attrib.type, GL_FALSE, stride, (void*)offset);
+            gl->glVertexAttribPointer(location, columnCount, (GLenum)attrib.type, GL_FALSE, stride, BUFFER_OFFSET(offset + i * columnSize));
+            gl->glEnableVertexAttribArray(location);
+            if (attrib.divisor != 0 && divisorFunc)
+                divisorFunc(location, attrib.divisor);
+        }
         offset += attrib.sizeInBytes;
     }
 }
 
-void VertexLayout::unbind(QOpenGLFunctions_3_2_Core* gl)
+void VertexLayout::unbind(QOpenGLFunctions_3_2_Core* gl, VertexAttribDivisorFunc divisorFunc)
 {
     for(auto attrib: attribs)
     {
-        gl->glDisableVertexAttribArray((int)attrib.usage);
+        int columns = attrib.count > 4 ? attrib.count / 4 : 1;
+        for (int i = 0; i < columns; i++) {
+            GLuint location = (GLuint)attrib.usage + i;
+            gl->glDisableVertexAttribArray(location);
+
+            // the vao is shared so the divisor has to be reset
+            if (attrib.divisor != 0 && divisorFunc)
+                divisorFunc(location, 0);
+        }
     }
 }
 
@@ -13,6 +13,7 @@ For more information see the LICENSE file
 #define VERTEXLAYOUT_H
 
 #include <QList>
+#include <QOpenGLFunctions>
 #include "../irisglfwd.h"
 #include "mesh.h"
 
@@ -27,10 +28,16 @@ struct VertexAttribute
     VertexAttribUsage usage;
 
     int type;//GL_FLOAT,GL_INT, etc
-    int count;//2 for vec2, 3 for vec3, etc
+    int count;//2 for vec2, 3 for vec3, 16 for mat4 etc
     int sizeInBytes;
+
+    // 0 advances per vertex, n advances once every n instances
+    int divisor;
 };
 
+// glVertexAttribDivisor isnt part of the 3.2 core functions so it's resolved by the GraphicsDevice
+typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFunc)(GLuint index, GLuint divisor);
+
 class VertexLayout
 {
     QList<VertexAttribute> attribs;
@@ -41,13 +48,14 @@ public:
     VertexLayout();
 
 	QList<VertexAttribute> getAttribs();
-    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes);
+    void addAttrib(VertexAttribUsage usage, int type, int count, int sizeInBytes, int divisor = 0);
 
     int getStride();
+    bool isInstanced();
 
     //todo: make this more efficient
-    void bind(QOpenGLFunctions_3_2_Core* gl);
-    void unbind(QOpenGLFunctions_3_2_Core* gl);
+    void bind(QOpenGLFunctions_3_2_Core* gl, VertexAttribDivisorFunc divisorFunc = nullptr);
+    void unbind(QOpenGLFunctions_3_2_Core* gl, VertexAttribDivisorFunc divisorFunc = nullptr);
 
     //default vertex layout for meshes
     static VertexLayout* createMeshDefault();
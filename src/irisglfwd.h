@@ -42,6 +42,7 @@ class Scene;
 class Shader;
 class VertexLayout;
 class TriMesh;
+struct SkinData;
 struct RenderData;
 class Viewport;
 class BillboardMaterial;
@@ -69,11 +70,16 @@ class AnimableProperty;
 class Bone;
 class Skeleton;
 class SkeletalAnimation;
+class BakedSkeletalAnimation;
+class SkeletonBinding;
+class PropertyAnimBinding;
+class AnimationMixer;
 template<typename T> class Key;
 typedef Key<float> FloatKey;
 class BoundingSphere;
 class VertexBuffer;
 class IndexBuffer;
+class UniformBuffer;
 class GraphicsDevice;
 class ContentManager;
 class SpriteBatch;
@@ -109,8 +115,13 @@ typedef QSharedPointer<PostProcessManager> PostProcessManagerPtr;
 typedef QSharedPointer<Bone> BonePtr;
 typedef QSharedPointer<Skeleton> SkeletonPtr;
 typedef QSharedPointer<SkeletalAnimation> SkeletalAnimationPtr;
+typedef QSharedPointer<BakedSkeletalAnimation> BakedSkeletalAnimationPtr;
+typedef QSharedPointer<SkeletonBinding> SkeletonBindingPtr;
+typedef QSharedPointer<PropertyAnimBinding> PropertyAnimBindingPtr;
+typedef QSharedPointer<AnimationMixer> AnimationMixerPtr;
 typedef QSharedPointer<VertexBuffer> VertexBufferPtr;
 typedef QSharedPointer<IndexBuffer> IndexBufferPtr;
+typedef QSharedPointer<UniformBuffer> UniformBufferPtr;
 typedef QSharedPointer<GraphicsDevice> GraphicsDevicePtr;
 typedef QSharedPointer<ContentManager> ContentManagerPtr;
 typedef QSharedPointer<SpriteBatch> SpriteBatchPtr;
@@ -57,33 +57,44 @@ void CustomMaterial::setValue(const QString &name, const QVariant &value)
 	}
 }
 
+int CustomMaterial::getUniformHandle(const QString& uniform)
+{
+	auto& cached = uniformHandleCache[&uniform];
+	if (cached.name != uniform || cached.name.isNull()) {
+		cached.name = uniform;
+		cached.handle = Shader::getUniformHandle(uniform.toUtf8());
+	}
+
+	return cached.handle;
+}
+
 void CustomMaterial::setUniformValues(GraphicsDevicePtr device, Property *prop)
 {
 	auto program = getProgram();
     if (prop->type == PropertyType::Bool) {
 		auto propVal = static_cast<BoolProperty*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
     }
 
 	if (prop->type == PropertyType::Int) {
 		auto propVal = static_cast<IntProperty*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
 	}
 
     if (prop->type == PropertyType::Float) {
 		auto propVal = static_cast<FloatProperty*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
     }
 
     // TODO, figure out a way for the default material to mix values... the ambient for one
     if (prop->type == PropertyType::Color) {
 		auto propVal = static_cast<ColorProperty*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
                                  QVector3D(propVal.redF(),
                                            propVal.greenF(),
                                            propVal.blueF()));
@@ -91,25 +102,25 @@ void CustomMaterial::setUniformValues(GraphicsDevicePtr device, Property *prop)
 
     if (prop->type == iris::PropertyType::Texture) {
         auto tprop = static_cast<TextureProperty*>(prop);
-		device->setShaderUniform(tprop->toggleValue.toStdString().c_str(), tprop->toggle);
+		device->setShaderUniform(getUniformHandle(tprop->toggleValue), tprop->toggle);
 		//device->setShaderUniform(tprop->toggleValue.toStdString().c_str(), true);
     }
 
 	if (prop->type == PropertyType::Vec2) {
 		auto propVal = static_cast<Vec2Property*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
 	}
 
 	if (prop->type == PropertyType::Vec3) {
 		auto propVal = static_cast<Vec3Property*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
 	}
 
 	if (prop->type == PropertyType::Vec4) {
 		auto propVal = static_cast<Vec4Property*>(prop)->value;
-		device->setShaderUniform(prop->uniform.toStdString().c_str(),
+		device->setShaderUniform(getUniformHandle(prop->uniform),
 			propVal);
 	}
 }
@@ -260,6 +271,7 @@ void CustomMaterial::parseProperties(const QJsonArray &widgetProps)
 void CustomMaterial::purge()
 {
     this->properties.clear();
+    uniformHandleCache.clear();
 }
 
 void CustomMaterial::setName(const QString &name)
@@ -429,6 +441,7 @@ CustomMaterialPtr CustomMaterial::create()
 void CustomMaterial::setProperties(QList<Property*> props)
 {
     this->properties = props;
+    uniformHandleCache.clear();
 }
 
 QList<Property *> CustomMaterial::getProperties()
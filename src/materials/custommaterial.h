@@ -17,6 +17,7 @@ For more information see the LICENSE file
 #include "../core/property.h"
 
 #include <QJsonObject>
+#include <QHash>
 
 class QOpenGLFunctions_3_2_Core;
 
@@ -82,6 +83,17 @@ public:
     void parseProperties(const QJsonArray&);
 
 	QJsonObject materialDefinitions;
+
+private:
+	// uniform handles keyed by the property's uniform string, re-resolved if the name changes
+	struct CachedUniform
+	{
+		QString name;
+		int handle;
+	};
+	QHash<const QString*, CachedUniform> uniformHandleCache;
+
+	int getUniformHandle(const QString& uniform);
 };
 
 }
@@ -0,0 +1,85 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef COUNTERRANDOM_H
+#define COUNTERRANDOM_H
+
+#include <QtGlobal>
+
+namespace iris
+{
+
+/**
+ * Counter based random number generator, the n-th number is a hash of the
+ * seed and n. There's no shared state so every owner gets the same sequence
+ * no matter which thread it runs on or what else is drawing numbers.
+ */
+class CounterRandom
+{
+public:
+    quint64 seed;
+    quint64 counter;
+
+    CounterRandom(quint64 seed = 0)
+    {
+        this->seed = seed;
+        counter = 0;
+    }
+
+    void setSeed(quint64 seed)
+    {
+        this->seed = seed;
+        counter = 0;
+    }
+
+    // the number at counter without advancing
+    static quint32 hash(quint64 seed, quint64 counter)
+    {
+        // splitmix64 finalizer
+        quint64 x = seed + (counter + 1) * 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x = x ^ (x >> 31);
+        return quint32(x >> 32);
+    }
+
+    quint32 next()
+    {
+        return hash(seed, counter++);
+    }
+
+    // uniform in [0, 1)
+    float nextFloat()
+    {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // n-th value of an item, uniform in [0, 1), the same as random() in particleupdate.vert
+    static float indexedFloat(quint32 seed, quint32 index, quint32 n)
+    {
+        return (hash32(seed ^ hash32(index * 8u + n)) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // 32 bit integer hash, cheap enough to run in a shader
+    static quint32 hash32(quint32 x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+};
+
+}
+
+#endif // COUNTERRANDOM_H
@@ -4,6 +4,7 @@
 #include "../animation/keyframeset.h"
 #include "../animation/animation.h"
 #include "../animation/propertyanim.h"
+#include "../animation/propertyanimbinding.h"
 #include "../core/property.h"
 #include "../graphics/shadowmap.h"
 
@@ -63,22 +64,30 @@ QVariant LightNode::getPropertyValue(QString valueName)
     return SceneNode::getPropertyValue(valueName);
 }
 
-void LightNode::updateAnimation(float time)
+void LightNode::bindPropertyAnims(PropertyAnimBinding* binding)
 {
-    if (!!animation) {
-        if(animation->hasPropertyAnim("intensity"))
-            intensity = animation->getFloatPropertyAnim("intensity")->getValue(time);
-        if(animation->hasPropertyAnim("lightColor"))
-            color = animation->getColorPropertyAnim("lightColor")->getValue(time);
-        if(animation->hasPropertyAnim("distance"))
-            distance = animation->getFloatPropertyAnim("distance")->getValue(time);
-        if(animation->hasPropertyAnim("spotCutOff"))
-            spotCutOff = animation->getFloatPropertyAnim("spotCutOff")->getValue(time);
-        if(animation->hasPropertyAnim("spotCutOffSoftness"))
-            spotCutOffSoftness = animation->getFloatPropertyAnim("spotCutOffSoftness")->getValue(time);
-    }
-
-    SceneNode::updateAnimation(time);
+    SceneNode::bindPropertyAnims(binding);
+
+    // light properties are sampled with the unlooped time, like before they were bound
+    binding->bind("intensity", [](SceneNode* node, PropertyAnim* anim, float time) {
+        static_cast<LightNode*>(node)->intensity = static_cast<FloatPropertyAnim*>(anim)->getValue(time);
+    }, true);
+
+    binding->bind("lightColor", [](SceneNode* node, PropertyAnim* anim, float time) {
+        static_cast<LightNode*>(node)->color = static_cast<ColorPropertyAnim*>(anim)->getValue(time);
+    }, true);
+
+    binding->bind("distance", [](SceneNode* node, PropertyAnim* anim, float time) {
+        static_cast<LightNode*>(node)->distance = static_cast<FloatPropertyAnim*>(anim)->getValue(time);
+    }, true);
+
+    binding->bind("spotCutOff", [](SceneNode* node, PropertyAnim* anim, float time) {
+        static_cast<LightNode*>(node)->spotCutOff = static_cast<FloatPropertyAnim*>(anim)->getValue(time);
+    }, true);
+
+    binding->bind("spotCutOffSoftness", [](SceneNode* node, PropertyAnim* anim, float time) {
+        static_cast<LightNode*>(node)->spotCutOffSoftness = static_cast<FloatPropertyAnim*>(anim)->getValue(time);
+    }, true);
 }
 
 LightNode::LightNode()
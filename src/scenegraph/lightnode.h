@@ -97,8 +97,6 @@ public:
     virtual QList<Property*> getProperties() override;
     virtual QVariant getPropertyValue(QString valueName) override;
 
-    void updateAnimation(float time) override;
-
 	ShadowMap* getShadowMap()
 	{
 		return shadowMap;
@@ -126,6 +124,9 @@ public:
 
 	SceneNodePtr createDuplicate() override;
 
+protected:
+    void bindPropertyAnims(PropertyAnimBinding* binding) override;
+
 private:
     LightNode();
 };
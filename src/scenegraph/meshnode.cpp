@@ -41,6 +41,8 @@ For more information see the LICENSE file
 #include "../animation/animableproperty.h"
 
 #include "../graphics/skeleton.h"
+#include "../graphics/skinning.h"
+#include "../geometry/trimesh.h"
 #include "../graphics/renderlist.h"
 
 namespace iris
@@ -53,6 +55,18 @@ MeshNode::MeshNode() {
     renderItem->type = RenderItemType::Mesh;
 
     faceCullingMode = FaceCullingMode::DefinedInMaterial;
+    pickingProxy = -1;
+
+    cpuSkinningEnabled = false;
+    skinnedTriMesh = nullptr;
+    skinnedTriMeshDirty = true;
+    skinnedSkeleton = nullptr;
+    skinnedPoseVersion = 0;
+}
+
+MeshNode::~MeshNode()
+{
+    delete skinnedTriMesh;
 }
 
 // @todo: cleanup previous mesh item
@@ -81,6 +95,10 @@ void MeshNode::setMesh(QString source)
     meshIndex = 0;
 
     renderItem->mesh = mesh;
+    // world bounds depend on the mesh
+    setHasDirtyChildren();
+    invalidateSkeletonBindings();
+    skinnedSkeleton = nullptr;
 }
 
 //should not be used on plain scene meshes
@@ -88,6 +106,9 @@ void MeshNode::setMesh(MeshPtr mesh)
 {
     this->mesh = mesh;
     renderItem->mesh = mesh;
+    setHasDirtyChildren();
+    invalidateSkeletonBindings();
+    skinnedSkeleton = nullptr;
 }
 
 MeshPtr MeshNode::getMesh()
@@ -112,18 +133,23 @@ void MeshNode::setMaterial(MaterialPtr material)
 }
 
 void MeshNode::submitRenderItems()
+{
+    submitRenderItems(scene->geometryRenderList, scene->shadowRenderList);
+}
+
+void MeshNode::submitRenderItems(RenderList* geometryList, RenderList* shadowList)
 {
     if (visible) {
         QMatrix4x4 transform = this->globalTransform;
 
-		renderItem->cullable = false;
+        // meshes without bounds (and skinned meshes) are always drawn
+        renderItem->cullable = !worldBounds.isNull();
         renderItem->physicsObject = isPhysicsBody;
 		renderItem->worldMatrix = transform;
         renderItem->guid = guid;
- 
-        if (!!mesh && renderItem->cullable) {
-            renderItem->boundingSphere.pos = transform * mesh->boundingSphere.pos;
-            renderItem->boundingSphere.radius = mesh->boundingSphere.radius * getMeshRadius();
+
+        if (renderItem->cullable) {
+            renderItem->boundingSphere = worldBounds.getMinimalEnclosingSphere();
         }
 
         if (!!material) {
@@ -148,14 +174,90 @@ void MeshNode::submitRenderItems()
 			}
         }
 
-        this->scene->geometryRenderList->add(renderItem);
+        geometryList->add(renderItem);
 
         if (this->getShadowCastingEnabled() && renderItem->renderStates.castShadows) {
-            this->scene->shadowRenderList->add(renderItem);
+            shadowList->add(renderItem);
         }
     }
 }
 
+void MeshNode::updateWorldBounds()
+{
+    // skinned meshes can be animated outside of their bind-pose bounds
+    if (!!mesh && !mesh->hasSkeleton()) {
+        worldBounds = mesh->aabb.transformed(globalTransform);
+    } else if (cpuSkinningEnabled && updateSkinning()) {
+        worldBounds = skinnedBounds.transformed(globalTransform);
+    } else {
+        worldBounds.setNegativeInfinity();
+    }
+}
+
+void MeshNode::setCpuSkinningEnabled(bool enabled)
+{
+    cpuSkinningEnabled = enabled;
+    skinnedSkeleton = nullptr;
+
+    if (!enabled) {
+        skinnedPositions.clear();
+        delete skinnedTriMesh;
+        skinnedTriMesh = nullptr;
+        skinnedBounds.setNegativeInfinity();
+    }
+
+    // bounds change either way
+    setHasDirtyChildren();
+}
+
+bool MeshNode::updateSkinning()
+{
+    if (!mesh || !mesh->hasSkeleton() || mesh->skinData == nullptr)
+        return false;
+
+    auto skeleton = mesh->getSkeleton().data();
+    if (skeleton == skinnedSkeleton && skeleton->poseVersion == skinnedPoseVersion)
+        return true;
+
+    skinnedSkeleton = skeleton;
+    skinnedPoseVersion = skeleton->poseVersion;
+
+    skinPositions(*mesh->skinData, skeleton->boneTransforms, skinnedPositions);
+
+    skinnedBounds.setNegativeInfinity();
+    for (const auto& pos : skinnedPositions)
+        skinnedBounds.merge(pos);
+
+    // posing every frame only costs a triangle rebuild when something picks
+    skinnedTriMeshDirty = true;
+
+    return true;
+}
+
+TriMesh* MeshNode::getPickingTriMesh()
+{
+    if (cpuSkinningEnabled && updateSkinning()) {
+        if (skinnedTriMeshDirty) {
+            // the bvh is rebuilt lazily by the trimesh on the next query
+            if (skinnedTriMesh == nullptr)
+                skinnedTriMesh = new TriMesh();
+            skinnedTriMesh->clear();
+
+            const auto& indices = mesh->skinData->indices;
+            for (int i = 0; i + 2 < indices.size(); i += 3) {
+                skinnedTriMesh->addTriangle(skinnedPositions[indices[i]],
+                                            skinnedPositions[indices[i + 1]],
+                                            skinnedPositions[indices[i + 2]]);
+            }
+            skinnedTriMeshDirty = false;
+        }
+
+        return skinnedTriMesh;
+    }
+
+    return !!mesh ? mesh->getTriMesh() : nullptr;
+}
+
 float MeshNode::getMeshRadius()
 {
     float scaleX = globalTransform.column(0).toVector3D().length();
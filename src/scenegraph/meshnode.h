@@ -29,6 +29,7 @@ namespace iris
 {
 
 class RenderItem;
+class RenderList;
 struct MeshMaterialData;
 
 class IModelReadProgress
@@ -93,6 +94,16 @@ public:
 
     RenderItem* renderItem;
 
+    // proxy in the scene's picking tree, see Scene::updatePickingTree
+    int pickingProxy;
+
+    // the mesh posed on the cpu, only kept up to date while cpu skinning is enabled
+    QVector<QVector3D> skinnedPositions;
+    TriMesh* skinnedTriMesh;
+    // skinnedTriMesh is older than skinnedPositions, rebuilt by getPickingTriMesh
+    bool skinnedTriMeshDirty;
+    AABB skinnedBounds;
+
     // For animated meshes, the rootBone's transform is what will be used as its transform
     // Since all its animations are based at the rootBone
     SceneNodePtr rootBone;
@@ -148,14 +159,43 @@ public:
 
     SceneNodePtr createDuplicate() override;
     virtual void submitRenderItems() override;
+
+    // submits into the given lists instead of the scene's, used for parallel extraction
+    void submitRenderItems(RenderList* geometryList, RenderList* shadowList);
+    virtual void updateWorldBounds() override;
+
+    /*
+     * Skinned meshes are posed on the gpu so their bounds and triangles are
+     * those of the bind pose. With cpu skinning enabled the mesh is also posed
+     * on the cpu whenever its skeleton changes, which gives it world bounds
+     * for culling and picking that follow the animation
+     */
+    void setCpuSkinningEnabled(bool enabled);
+    bool isCpuSkinningEnabled() const
+    {
+        return cpuSkinningEnabled;
+    }
+
+    // poses the mesh if the skeleton changed, returns false if it cant be skinned
+    bool updateSkinning();
+
+    // the skinned triangles when cpu skinning is enabled, otherwise the mesh's
+    TriMesh* getPickingTriMesh();
     float getMeshRadius();
     BoundingSphere getTransformedBoundingSphere();
 
     FaceCullingMode getFaceCullingMode() const;
     void setFaceCullingMode(const FaceCullingMode &value);
 
+    ~MeshNode();
+
 private:
     MeshNode();
+
+    bool cpuSkinningEnabled;
+    // skeleton pose the skinned data was built from
+    Skeleton* skinnedSkeleton;
+    unsigned int skinnedPoseVersion;
 };
 
 }
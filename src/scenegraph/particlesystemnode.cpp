@@ -26,13 +26,17 @@ For more information see the LICENSE file
 #include "../materials/defaultmaterial.h"
 #include "../materials/materialhelper.h"
 #include "../graphics/renderitem.h"
-#include "../graphics/particle.h"
+#include "../graphics/particlepool.h"
 #include "../graphics/particlerender.h"
+#include "../graphics/gpuparticlesimulator.h"
 #include "../graphics/renderlist.h"
 
 #include "../scenegraph/scene.h"
 #include "../scenegraph/scenenode.h"
 
+// updates recorded while the system isn't rendered are merged past this
+#define PARTICLE_GPU_MAX_STEPS 4
+
 namespace iris
 {
 
@@ -52,6 +56,8 @@ ParticleSystemNode::ParticleSystemNode() {
     billboardScale = 1.f;
 
     useAdditive = true;
+    depthSort = false;
+    gpuSimulation = false;
     randomRotation = true;
     dissipate = true;
     dissipateInv = false;
@@ -60,9 +66,16 @@ ParticleSystemNode::ParticleSystemNode() {
     particleScale = 1.0f;
     lifeLength = 1.0f;
 
-    speedError = lifeError = scaleError = 0;
+    maxParticles = 5000;
+    particles.setCapacity(maxParticles);
 
     renderer = new ParticleRenderer();
+    gpuSimulator = new GpuParticleSimulator();
+
+    emitIndex = 0;
+    setRandomSeed(nodeId);
+
+    speedError = lifeError = scaleError = 0;
 
     renderItem = new RenderItem();
     renderItem->type = RenderItemType::ParticleSystem;
@@ -81,6 +94,7 @@ ParticleSystemNode::~ParticleSystemNode()
     delete renderItem;
     delete boundsRenderItem;
     delete renderer;
+    delete gpuSimulator;
 }
 
 void ParticleSystemNode::setBlendMode(bool useAddittive)
@@ -88,6 +102,21 @@ void ParticleSystemNode::setBlendMode(bool useAddittive)
     renderer->useAdditive = this->useAdditive = useAddittive;
 }
 
+void ParticleSystemNode::setDepthSorting(bool depthSort)
+{
+    renderer->depthSort = this->depthSort = depthSort;
+}
+
+void ParticleSystemNode::setGpuSimulation(bool gpuSimulation)
+{
+    this->gpuSimulation = gpuSimulation;
+
+    particles.clear();
+    emitIndex = 0;
+    gpuSimulator->reset();
+    gpuSteps.clear();
+}
+
 void ParticleSystemNode::setBillboardScale(float scale)
 {
 //    billboardScale = scale;
@@ -110,16 +139,31 @@ void ParticleSystemNode::generateParticles(float delta) {
     int count = (int) floor(particlesToCreate);
     float partialParticle = fmod(particlesToCreate, 1);
 
+    if (gpuSimulation) {
+        if (random.nextFloat() < partialParticle)
+            count++;
+        queueGpuStep(delta, count);
+        return;
+    }
+
+    if (particles.capacity != maxParticles)
+        particles.setCapacity(maxParticles);
+
     for (int i = 0; i < count; i++) {
         emitParticle();
     }
 
-    if (static_cast <float> (rand()) / static_cast <float> (RAND_MAX) < partialParticle) {
+    if (random.nextFloat() < partialParticle) {
         emitParticle();
     }
 }
 
 void ParticleSystemNode::emitParticle() {
+    // the index is used up even when the particle is dropped, like a gpu slot that's still alive
+    quint32 particle = emitIndex++;
+    if (particles.isFull())
+        return;
+
     QVector4D dir = QVector4D(QVector3D(0, 1, 0), 0);
     QVector4D particleDirection = this->globalTransform * dir;
 
@@ -128,79 +172,107 @@ void ParticleSystemNode::emitParticle() {
     // QVector3D velocity = generateRandomUnitVector();
 
     velocity.normalize();
-    velocity *= generateValue(speed, speedError);
-    float scl = generateValue(particleScale, scaleError);
-    float ll = generateValue(lifeLength, lifeError);
+    velocity *= generateValue(speed, speedError, particleRandom(particle, 0));
+    float scl = generateValue(particleScale, scaleError, particleRandom(particle, 1));
+    float ll = generateValue(lifeLength, lifeError, particleRandom(particle, 2));
+    auto unitVector = generateRandomUnitVector(particleRandom(particle, 3), particleRandom(particle, 4));
 
-    // reuse particles! this is bad.
-    // change later after atlases
     boundDimension = QVector3D(1, 1, 1) * this->scale;
-    addParticle(new Particle(this->getGlobalPosition() + boundDimension * generateRandomUnitVector(),
-                             velocity,
-                             gravityComplement,
-                             ll,
-                             generateRotation(),
-                             scl));
+    particles.emit(this->getGlobalPosition() + boundDimension * unitVector,
+                   velocity,
+                   gravityComplement,
+                   ll,
+                   generateRotation(particleRandom(particle, 5)),
+                   scl);
 }
 
-float ParticleSystemNode::generateValue(float average, float errorMargin) {
-    float offset = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) - 0.5f) * 2.f * errorMargin;
+void ParticleSystemNode::queueGpuStep(float delta, int emitCount)
+{
+    // nothing renders the system, fold this update into the last one
+    if (gpuSteps.size() >= PARTICLE_GPU_MAX_STEPS) {
+        gpuSteps.last().delta += delta;
+        gpuSteps.last().emitCount += emitCount;
+        return;
+    }
+
+    // same emitter as emitParticle
+    GpuParticleStep step;
+    step.delta = delta;
+    step.emitCount = emitCount;
+    step.emitterPosition = this->getGlobalPosition();
+    step.emitDirection = QVector3D(this->globalTransform * QVector4D(0, 1, 0, 0)).normalized();
+    step.boundDimension = QVector3D(1, 1, 1) * this->scale;
+    step.speed = speed;
+    step.speedError = speedError;
+    step.particleScale = particleScale;
+    step.scaleError = scaleError;
+    step.lifeLength = lifeLength;
+    step.lifeError = lifeError;
+    step.gravity = gravityComplement;
+    step.randomRotation = randomRotation;
+    step.dissipate = dissipate;
+    step.dissipateInv = dissipateInv;
+    gpuSteps.append(step);
+}
+
+float ParticleSystemNode::particleRandom(quint32 particle, quint32 n) {
+    return CounterRandom::indexedFloat(particleSeed, particle, n);
+}
+
+float ParticleSystemNode::generateValue(float average, float errorMargin, float r) {
+    float offset = (r - 0.5f) * 2.f * errorMargin;
     return average + offset;
 }
 
-float ParticleSystemNode::generateRotation() {
+float ParticleSystemNode::generateRotation(float r) {
     if (randomRotation) {
-        return static_cast<float>(rand()) / static_cast<float>(RAND_MAX / 360.f);
+        return r * 360.f;
     } else {
         return 0;
     }
 }
 
-QVector3D ParticleSystemNode::generateRandomUnitVector() {
-    float theta = (float) (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f * M_PI);
-    float z = (static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.f) - 1.f;
+QVector3D ParticleSystemNode::generateRandomUnitVector(float r0, float r1) {
+    float theta = (float) (r0 * 2.f * M_PI);
+    float z = (r1 * 2.f) - 1.f;
     float rootOneMinusZSquared = (float) sqrt(1 - z * z);
     float x = (float) (rootOneMinusZSquared * cos(theta));
     float y = (float) (rootOneMinusZSquared * sin(theta));
     return QVector3D(x, y, z);
 }
 
-void ParticleSystemNode::update(float delta) {
-    SceneNode::update(delta);
+void ParticleSystemNode::integrateParticles(float delta, int begin, int end)
+{
+    // in the future we can call behavior management here, add more forces such as wind
+    particles.integrate(delta, dissipate, dissipateInv, particleScale, begin, end);
+}
 
+void ParticleSystemNode::simulate(float delta)
+{
     generateParticles(delta);
-    //std::list<Particle*>::iterator it = particles.begin();
-
-	for (int i = 0; i < particles.size(); i++) {
-		auto p = particles[i];
-
-        p->velocity += QVector3D(0, p->GRAVITY * p->gravityEffect * delta, 0);
-        //p.velocity.setY(p.velocity.y() + GRAVITY * gravityEffect * delta);
-        QVector3D change = p->velocity;
-        change *= delta;
-        p->position += change;
-        //p.position += p->velocity * delta;
-        p->elapsedTime += delta;
-
-        // in the future we can call behavior management here, add more forces such as wind
-        if (dissipate && p->elapsedTime > 0) {
-            if (dissipateInv) {
-                p->scale = MathHelper::lerp((p->elapsedTime / p->lifeLength), 0, particleScale);
-            } else {
-                p->scale *= 1.0f - (p->elapsedTime / p->lifeLength);
-            }
-        }
-
-        if (p->elapsedTime > p->lifeLength) {
-			particles.erase(particles.begin() + i);
-			i--;
-        }
-    }
+    integrateParticles(delta, 0, particles.count);
+    particles.removeExpired();
 }
 
 void ParticleSystemNode::renderParticles(GraphicsDevicePtr device, RenderData* renderData, ShaderPtr shader)
 {
     renderer->icon = texture;
+
+    // the simulator draws instanced, fall back to the cpu from the next update
+    if (gpuSimulation && !device->supportsInstancing())
+        setGpuSimulation(false);
+
+    if (gpuSimulation) {
+        gpuSimulator->setCapacity(maxParticles);
+        for (auto& step : gpuSteps)
+            gpuSimulator->simulate(device, step);
+        gpuSteps.clear();
+
+        if (gpuSimulator->hasState())
+            renderer->render(device, shader, renderData, gpuSimulator->getParticleBuffer(), gpuSimulator->getCapacity());
+        return;
+    }
+
     renderer->render(device, shader, renderData, this->particles);
 }
 
@@ -220,6 +292,8 @@ SceneNodePtr ParticleSystemNode::createDuplicate()
 	ps->scaleFactor			= this->scaleFactor;
 	ps->speedFactor			= this->speedFactor;
 	ps->useAdditive			= this->useAdditive;
+	ps->setDepthSorting(this->depthSort);
+	ps->setGpuSimulation(this->gpuSimulation);
 
 	ps->gravityComplement	= this->gravityComplement;
 	ps->lifeLength			= this->lifeLength;
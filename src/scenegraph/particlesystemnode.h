@@ -16,6 +16,9 @@ For more information see the LICENSE file
 #include "../scenegraph/scenenode.h"
 #include "../core/irisutils.h"
 #include "../graphics/texture2d.h"
+#include "../graphics/particlepool.h"
+#include "../graphics/gpuparticlesimulator.h"
+#include "../math/counterrandom.h"
 
 class QOpenGLShaderProgram;
 
@@ -23,7 +26,6 @@ namespace iris
 {
 
 class RenderItem;
-class Particle;
 class ParticleRenderer;
 
 class ParticleSystemNode : public SceneNode
@@ -46,11 +48,14 @@ public:
     float scaleFactor;
     float speedFactor;
     bool useAdditive;
+    bool depthSort;
+    bool gpuSimulation;
 
     float gravityComplement;
     float lifeLength;
     float particleScale;
 
+    // capacity of the particle pool, emitting stops while it's full
     int maxParticles;
     float billboardScale;
 
@@ -66,6 +71,17 @@ public:
 
     void setBlendMode(bool useAddittive);
 
+    // sorts alpha blended particles by camera depth before drawing
+    void setDepthSorting(bool depthSort);
+
+    /*
+     * Simulates the particles with transform feedback instead, for emitters
+     * too large to update on the cpu. The updates are recorded by the scene
+     * and run when the system is rendered, see GpuParticleSimulator
+     * Switching removes all particles
+     */
+    void setGpuSimulation(bool gpuSimulation);
+
     void setDissipation(bool b) {
         this->dissipate = b;
     }
@@ -98,15 +114,42 @@ public:
         this->posDir = direction;
     }
 
+    /*
+     * Every random value is drawn from the seed so a system emits the same
+     * particles for the same seed regardless of threads or other systems
+     * A particle's values are hashed from its emission index, the same way
+     * the gpu simulator does it, so both modes emit the same particles
+     * The seed defaults to the node id
+     */
+    void setRandomSeed(quint64 seed) {
+        random.setSeed(seed);
+        particleSeed = quint32(seed ^ (seed >> 32));
+        gpuSimulator->setSeed(particleSeed);
+    }
+
+    // emits this frame's particles from the current global transform
     void generateParticles(float delta);
 
+    // moves the particles in [begin, end), see ParticlePool::integrate
+    void integrateParticles(float delta, int begin, int end);
+
+    // emits, integrates and removes expired particles, the scene calls this
+    // after the hierarchy is updated
+    void simulate(float delta);
+
     void emitParticle();
 
-    float generateValue(float average, float errorMargin);
+    // records an update for the gpu simulator, called instead of emitting in gpu mode
+    void queueGpuStep(float delta, int emitCount);
 
-    float generateRotation();
+    // n-th random value of the particle, see CounterRandom::indexedFloat
+    float particleRandom(quint32 particle, quint32 n);
 
-    QVector3D generateRandomUnitVector();
+    float generateValue(float average, float errorMargin, float r);
+
+    float generateRotation(float r);
+
+    QVector3D generateRandomUnitVector(float r0, float r1);
 
     void setPPS(float pps) {
         this->particlesPerSecond = pps;
@@ -145,7 +188,7 @@ public:
     }
 
     void setPos(QVector3D p) {
-        this->pos = p;
+        setLocalPos(p);
     }
 
     void setTexture(QSharedPointer<iris::Texture2D> tex) {
@@ -154,23 +197,24 @@ public:
 
     void setBillboardScale(float scale);
 
-    void update(float delta) override;
-
     void renderParticles(GraphicsDevicePtr device, RenderData* renderData, ShaderPtr shader);
 
-    void addParticle(Particle *particle) {
-        particles.push_back(particle);
-    }
-
     ~ParticleSystemNode();
 
     ParticleRenderer* renderer;
+    GpuParticleSimulator* gpuSimulator;
+    QVector<GpuParticleStep> gpuSteps;
 
 	SceneNodePtr createDuplicate() override;
 
     ParticleSystemNode();
 
-    std::vector<Particle*> particles;
+    ParticlePool particles;
+    // decides the partial particle of each update
+    CounterRandom random;
+    quint32 particleSeed;
+    // particles emitted so far on the cpu, it picks each particle's random values
+    quint32 emitIndex;
 
     MaterialPtr material;
     RenderItem* renderItem;
@@ -23,16 +23,30 @@ For more information see the LICENSE file
 #include "../geometry/trimesh.h"
 #include "../core/irisutils.h"
 #include "../graphics/renderlist.h"
+#include "transformstore.h"
+#include "../geometry/dynamicaabbtree.h"
+#include "../animation/skeletonbinding.h"
+#include "../animation/animationmixer.h"
+#include "../graphics/skeleton.h"
 
 #include "physics/environment.h"
 #include "math/intersectionhelper.h"
 
 #include <QtMultimedia/QMediaPlayer>
+#include <QtConcurrent>
+#include <QThread>
 // #include <QtMultimedia/QMediaPlaylist>
 
 namespace iris
 {
 
+// below this the cost of dispatching jobs outweighs the work
+#define PARALLEL_UPDATE_MIN_NODES 512
+#define PARALLEL_ANIMATION_MIN_JOBS 8
+#define PARALLEL_PARTICLE_MIN_PARTICLES 4096
+// particles integrated per job, large systems are split into several
+#define PARTICLE_JOB_SIZE 4096
+
 Scene::Scene()
 {
     rootNode = SceneNode::create();
@@ -141,6 +155,12 @@ Scene::Scene()
     shadowRenderList = new RenderList();
     gizmoRenderList = new RenderList();
 
+    parallelUpdateEnabled = true;
+    deferSkeletalAnimation = false;
+    transformStoreEnabled = false;
+    transformStore = new TransformStore();
+    pickingTree = new DynamicAABBTree();
+
 	time = 0;
 
     environment = QSharedPointer<Environment>(new Environment(geometryRenderList));
@@ -257,7 +277,82 @@ void Scene::setAmbientMusicVolume(float volume)
 
 void Scene::updateSceneAnimation(float time)
 {
+    deferSkeletalAnimation = parallelUpdateEnabled && QThread::idealThreadCount() > 1;
     rootNode->updateAnimation(time);
+    deferSkeletalAnimation = false;
+
+    // deferred skeletons dont contain other animated nodes so evaluating
+    // them after the walk gives the same result as evaluating them during it
+    if (skeletalAnimationJobs.size() >= PARALLEL_ANIMATION_MIN_JOBS) {
+        updateSkeletalAnimationsParallel();
+    } else {
+        for (const auto& job : skeletalAnimationJobs) {
+            if (!!job.mixer)
+                job.mixer->apply(job.binding, job.time);
+            else
+                job.binding->applyAnimation(job.time);
+        }
+    }
+
+    skeletalAnimationJobs.clear();
+}
+
+// Bindings that pose the same skeleton are grouped so they run in order on one
+// thread, the groups are then evaluated on the thread pool. Transforms are
+// published to the rest of the scene afterwards on this thread
+void Scene::updateSkeletalAnimationsParallel()
+{
+    int jobCount = skeletalAnimationJobs.size();
+
+    // union-find over jobs sharing a skeleton
+    QVector<int> groupRoots(jobCount);
+    for (int i = 0; i < jobCount; i++)
+        groupRoots[i] = i;
+
+    auto findRoot = [&groupRoots](int i) {
+        while (groupRoots[i] != i) {
+            groupRoots[i] = groupRoots[groupRoots[i]];
+            i = groupRoots[i];
+        }
+        return i;
+    };
+
+    QHash<Skeleton*, int> skeletonOwners;
+    for (int i = 0; i < jobCount; i++) {
+        for (const auto& skinned : skeletalAnimationJobs[i].binding->skinnedMeshes) {
+            auto owner = skeletonOwners.find(skinned.skeleton);
+            if (owner == skeletonOwners.end())
+                skeletonOwners.insert(skinned.skeleton, i);
+            else
+                groupRoots[findRoot(i)] = findRoot(owner.value());
+        }
+    }
+
+    // jobs keep their hierarchy order within a group
+    QHash<int, int> groupIndices;
+    QVector<QVector<int>> groups;
+    for (int i = 0; i < jobCount; i++) {
+        int root = findRoot(i);
+        auto group = groupIndices.find(root);
+        if (group == groupIndices.end()) {
+            group = groupIndices.insert(root, groups.size());
+            groups.append(QVector<int>());
+        }
+        groups[group.value()].append(i);
+    }
+
+    QtConcurrent::blockingMap(groups, [this](const QVector<int>& group) {
+        for (int i : group) {
+            const auto& job = skeletalAnimationJobs[i];
+            if (!!job.mixer)
+                job.mixer->evaluate(job.binding, job.time);
+            else
+                job.binding->evaluate(job.time);
+        }
+    });
+
+    for (const auto& job : skeletalAnimationJobs)
+        job.binding->publishTransforms();
 }
 
 void Scene::update(float dt)
@@ -295,23 +390,161 @@ void Scene::update(float dt)
 		mesh->setGlobalRot(QQuaternion(rot.w(), rot.x(), rot.y(), rot.z()));
 	}
 
+	if (transformStoreEnabled)
+		transformStore->update(rootNode);
+
 	// Cameras aren't always a part of the scene hierarchy, so their matrices are updated here
 	if (!!camera) {
 		camera->update(dt);
 		camera->updateCameraMatrices();
 	}
 
-	rootNode->update(dt);
+	bool parallel = parallelUpdateEnabled &&
+					nodes.size() >= PARALLEL_UPDATE_MIN_NODES &&
+					QThread::idealThreadCount() > 1;
 
-	for (const auto &mesh : meshes) {
-		mesh->submitRenderItems();
+	if (parallel) {
+		updateNodesParallel(dt);
+		submitMeshesParallel();
+	} else {
+		rootNode->update(dt);
+
+		for (const auto &mesh : meshes) {
+			mesh->submitRenderItems();
+		}
 	}
 
+    updateParticleSystems(dt);
+
     for (const auto &particle : particleSystems) {
         particle->submitRenderItems();
     }
 
     if (renderSky) this->geometryRenderList->add(skyRenderItem);
+
+    updatePickingTree();
+}
+
+// Splits the hierarchy into independent subtrees and updates them on the thread pool.
+// Nodes that get split have their own transform updated before their children and
+// their bounds merged after, the same as SceneNode::update does
+void Scene::updateNodesParallel(float dt)
+{
+    // only nodes that use the base update can be split, clean subtrees
+    // are skipped by SceneNode::update so splitting them gains nothing
+    auto canSplit = [](SceneNode* node) {
+        return node->hasChildren() && node->hasDirtyChildren &&
+               node->sceneNodeType != SceneNodeType::Camera;
+    };
+
+    // replacing each split node with its children keeps the jobs in hierarchy order
+    int targetJobCount = QThread::idealThreadCount() * 4;
+    QVector<SceneNode*> jobs = { rootNode.data() };
+    QVector<SceneNode*> splitNodes;
+    bool didSplit = true;
+    while (didSplit && jobs.size() < targetJobCount) {
+        didSplit = false;
+        QVector<SceneNode*> nextJobs;
+        for (auto node : jobs) {
+            if (canSplit(node)) {
+                node->hasDirtyChildren = false;
+                node->updateTransform();
+                splitNodes.append(node);
+                for (auto& child : node->children)
+                    nextJobs.append(child.data());
+                didSplit = true;
+            } else {
+                nextJobs.append(node);
+            }
+        }
+        jobs = nextJobs;
+    }
+
+    QtConcurrent::blockingMap(jobs, [dt](SceneNode* node) {
+        node->update(dt);
+    });
+
+    // children were split after their parents so walking backwards merges bottom-up
+    for (int i = splitNodes.size() - 1; i >= 0; i--)
+        splitNodes[i]->updateSubtreeBounds();
+}
+
+// Simulated once the hierarchy is updated so emitters use this frame's transforms.
+// Each system draws from its own counter based generator and particles dont
+// interact, so the work is split across systems for emitting and expiring and
+// across chunks of each system's pool for integrating. The result is the same
+// as simulating every system in turn on one thread
+void Scene::updateParticleSystems(float dt)
+{
+    particleJobs.clear();
+    QVector<ParticleSystemNode*> systems;
+    int particleCount = 0;
+    for (const auto& particle : particleSystems) {
+        systems.append(particle.data());
+        particleCount += particle->particles.count;
+    }
+
+    bool parallel = parallelUpdateEnabled &&
+                    particleCount >= PARALLEL_PARTICLE_MIN_PARTICLES &&
+                    QThread::idealThreadCount() > 1;
+
+    if (!parallel) {
+        for (auto system : systems)
+            system->simulate(dt);
+        return;
+    }
+
+    QtConcurrent::blockingMap(systems, [dt](ParticleSystemNode* system) {
+        system->generateParticles(dt);
+    });
+
+    for (auto system : systems) {
+        for (int begin = 0; begin < system->particles.count; begin += PARTICLE_JOB_SIZE) {
+            int end = qMin(begin + PARTICLE_JOB_SIZE, system->particles.count);
+            particleJobs.append({system, begin, end});
+        }
+    }
+
+    QtConcurrent::blockingMap(particleJobs, [dt](const ParticleJob& job) {
+        job.system->integrateParticles(dt, job.begin, job.end);
+    });
+
+    QtConcurrent::blockingMap(systems, [](ParticleSystemNode* system) {
+        system->particles.removeExpired();
+    });
+}
+
+// Each worker submits a contiguous range of meshes into its own lists, the lists
+// are then merged in range order so the result matches submitting serially
+void Scene::submitMeshesParallel()
+{
+    meshJobs.clear();
+    for (const auto &mesh : meshes)
+        meshJobs.append(mesh.data());
+
+    int chunkCount = qMin(QThread::idealThreadCount(), meshJobs.size());
+    while (workerGeometryLists.size() < chunkCount) {
+        workerGeometryLists.append(new RenderList());
+        workerShadowLists.append(new RenderList());
+    }
+
+    QVector<int> chunks;
+    for (int i = 0; i < chunkCount; i++)
+        chunks.append(i);
+
+    QtConcurrent::blockingMap(chunks, [this, chunkCount](int chunk) {
+        int start = meshJobs.size() * chunk / chunkCount;
+        int end = meshJobs.size() * (chunk + 1) / chunkCount;
+        for (int i = start; i < end; i++)
+            meshJobs[i]->submitRenderItems(workerGeometryLists[chunk], workerShadowLists[chunk]);
+    });
+
+    for (int i = 0; i < chunkCount; i++) {
+        geometryRenderList->addItems(*workerGeometryLists[i]);
+        shadowRenderList->addItems(*workerShadowLists[i]);
+        workerGeometryLists[i]->clear();
+        workerShadowLists[i]->clear();
+    }
 }
 
 void Scene::render()
@@ -325,7 +558,22 @@ void Scene::rayCast(const QVector3D& segStart,
 					uint64_t pickingMask,
 					bool allowUnpickable)
 {
-    rayCast(rootNode, segStart, segEnd, hitList, pickingMask, allowUnpickable);
+    int firstHit = hitList.size();
+
+    // only meshes whose bounds the segment passes through get the triangle test
+    QVector<void*> candidates;
+    pickingTree->querySegment(segStart, segEnd, candidates);
+    for (auto candidate : candidates) {
+        rayCastMesh(static_cast<MeshNode*>(candidate), segStart, segEnd, hitList, pickingMask, allowUnpickable);
+    }
+
+    for (auto meshNode : unboundedPickingNodes) {
+        rayCastMesh(meshNode, segStart, segEnd, hitList, pickingMask, allowUnpickable);
+    }
+
+    std::stable_sort(hitList.begin() + firstHit, hitList.end(), [](const PickingResult& a, const PickingResult& b) {
+        return a.distanceFromStartSqrd < b.distanceFromStartSqrd;
+    });
 }
 
 void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
@@ -335,44 +583,8 @@ void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
 					uint64_t pickingMask,
 					bool allowUnpickable)
 {
-	if ((sceneNode->getSceneNodeType() == iris::SceneNodeType::Mesh) &&
-		(sceneNode->isPickable() || allowUnpickable) &&
-		(sceneNode->pickingGroups & pickingMask) == pickingMask)// check flag
-	{
-        auto meshNode = sceneNode.staticCast<iris::MeshNode>();
-        auto mesh = meshNode->getMesh();
-        if(mesh != nullptr)
-        {
-            
-            // transform segment to local space
-            auto invTransform = meshNode->globalTransform.inverted();
-            auto a = invTransform * segStart;
-            auto b = invTransform * segEnd;
-
-			// ray-sphere intersection first
-			auto mesh = meshNode->getMesh();
-			auto sphere = mesh->getBoundingSphere();
-			float t;
-			QVector3D hitPoint;
-			if (IntersectionHelper::raySphereIntersects(a, (b - a).normalized(), sphere.pos, sphere.radius, t, hitPoint)) {
-				auto triMesh = meshNode->getMesh()->getTriMesh();
-
-				QList<iris::TriangleIntersectionResult> results;
-				if (int resultCount = triMesh->getSegmentIntersections(a, b, results)) {
-					for (auto triResult : results) {
-						// convert hit to world space
-						auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
-
-						PickingResult pick;
-						pick.hitNode = sceneNode;
-						pick.hitPoint = hitPoint;
-						pick.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
-
-						hitList.append(pick);
-					}
-				}
-			}
-        }
+    if (sceneNode->getSceneNodeType() == iris::SceneNodeType::Mesh) {
+        rayCastMesh(sceneNode.staticCast<iris::MeshNode>().data(), segStart, segEnd, hitList, pickingMask, allowUnpickable);
     }
 
     for (auto child : sceneNode->children) {
@@ -380,6 +592,80 @@ void Scene::rayCast(const QSharedPointer<iris::SceneNode>& sceneNode,
     }
 }
 
+void Scene::rayCastMesh(MeshNode* meshNode,
+                        const QVector3D& segStart,
+                        const QVector3D& segEnd,
+                        QList<iris::PickingResult>& hitList,
+                        uint64_t pickingMask,
+                        bool allowUnpickable)
+{
+	if (!(meshNode->isPickable() || allowUnpickable) ||
+		(meshNode->pickingGroups & pickingMask) != pickingMask)// check flag
+		return;
+
+    auto mesh = meshNode->getMesh();
+    if (mesh == nullptr)
+        return;
+
+    // transform segment to local space
+    auto invTransform = meshNode->globalTransform.inverted();
+    auto a = invTransform * segStart;
+    auto b = invTransform * segEnd;
+
+	// ray-sphere intersection first, the bind pose sphere doesnt hold
+	// cpu skinned meshes but the picking tree has already tested their bounds
+	auto sphere = mesh->getBoundingSphere();
+	float t;
+	QVector3D hitPoint;
+	if (meshNode->isCpuSkinningEnabled() ||
+		IntersectionHelper::raySphereIntersects(a, (b - a).normalized(), sphere.pos, sphere.radius, t, hitPoint)) {
+		auto triMesh = meshNode->getPickingTriMesh();
+
+		QList<iris::TriangleIntersectionResult> results;
+		if (triMesh->getSegmentIntersections(a, b, results)) {
+			for (auto triResult : results) {
+				// convert hit to world space
+				auto hitPoint = meshNode->globalTransform * triResult.hitPoint;
+
+				PickingResult pick;
+				pick.hitNode = meshNode->sharedFromThis();
+				pick.hitPoint = hitPoint;
+				pick.distanceFromStartSqrd = (hitPoint - segStart).lengthSquared();
+
+				hitList.append(pick);
+			}
+		}
+	}
+}
+
+// Keeps the picking tree in step with the meshes' world bounds, proxies only
+// get reinserted once their node has moved outside of the padded box
+void Scene::updatePickingTree()
+{
+    unboundedPickingNodes.clear();
+
+    for (const auto &mesh : meshes) {
+        auto meshNode = mesh.data();
+
+        // skinned meshes have no world bounds unless they're cpu skinned so they're always tested
+        if (meshNode->worldBounds.isNull()) {
+            if (meshNode->pickingProxy != DYNAMIC_AABB_TREE_NULL_NODE) {
+                pickingTree->destroyProxy(meshNode->pickingProxy);
+                meshNode->pickingProxy = DYNAMIC_AABB_TREE_NULL_NODE;
+            }
+
+            if (meshNode->getMesh() != nullptr)
+                unboundedPickingNodes.append(meshNode);
+            continue;
+        }
+
+        if (meshNode->pickingProxy == DYNAMIC_AABB_TREE_NULL_NODE)
+            meshNode->pickingProxy = pickingTree->createProxy(meshNode->worldBounds, meshNode);
+        else
+            pickingTree->moveProxy(meshNode->pickingProxy, meshNode->worldBounds);
+    }
+}
+
 void Scene::addNode(SceneNodePtr node)
 {
     if (!!node->scene) {
@@ -419,6 +705,7 @@ void Scene::addNode(SceneNodePtr node)
 	}
 
 	nodes.insert(node->getGUID(), node);
+	transformStore->invalidate();
 }
 
 void Scene::removeNode(SceneNodePtr node)
@@ -428,7 +715,14 @@ void Scene::removeNode(SceneNodePtr node)
     }
 
     if (node->sceneNodeType == SceneNodeType::Mesh) {
-        meshes.remove(meshes.key(node.staticCast<iris::MeshNode>()));
+        auto meshNode = node.staticCast<iris::MeshNode>();
+        meshes.remove(meshes.key(meshNode));
+
+        if (meshNode->pickingProxy != DYNAMIC_AABB_TREE_NULL_NODE) {
+            pickingTree->destroyProxy(meshNode->pickingProxy);
+            meshNode->pickingProxy = DYNAMIC_AABB_TREE_NULL_NODE;
+        }
+        unboundedPickingNodes.removeOne(meshNode.data());
     }
 
     if (node->sceneNodeType == SceneNodeType::ParticleSystem) {
@@ -454,12 +748,23 @@ void Scene::removeNode(SceneNodePtr node)
 	}
 
 	nodes.remove(node->getGUID());
+	node->transformIndex = -1;
+	transformStore->invalidate();
 
     for (auto &child : node->children) {
         removeNode(child);
     }
 }
 
+void Scene::setTransformStoreEnabled(bool enabled)
+{
+    // indices may be stale after running without the store
+    if (enabled && !transformStoreEnabled)
+        transformStore->invalidate();
+
+    transformStoreEnabled = enabled;
+}
+
 void Scene::setCamera(CameraNodePtr cameraNode)
 {
     camera = cameraNode;
@@ -502,6 +807,14 @@ void Scene::cleanup()
     delete geometryRenderList;
     delete shadowRenderList;
     delete gizmoRenderList;
+    qDeleteAll(workerGeometryLists);
+    workerGeometryLists.clear();
+    qDeleteAll(workerShadowLists);
+    workerShadowLists.clear();
+    delete transformStore;
+    transformStore = nullptr;
+    delete pickingTree;
+    pickingTree = nullptr;
 }
 
 }
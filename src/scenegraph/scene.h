@@ -30,12 +30,31 @@ namespace iris
 class RenderItem;
 class RenderList;
 class Environment;
+class TransformStore;
+class DynamicAABBTree;
 
 enum class SceneRenderFlags : int
 {
     Vr = 0x1
 };
 
+// a skeleton whose evaluation was deferred until the whole tree is animated
+struct SkeletalAnimationJob
+{
+    SkeletonBindingPtr binding;
+    // blends the pose instead of the binding's own animation when set
+    AnimationMixerPtr mixer;
+    float time;
+};
+
+// a range of one particle system's pool to integrate
+struct ParticleJob
+{
+    ParticleSystemNode* system;
+    int begin;
+    int end;
+};
+
 struct PickingResult
 {
     iris::SceneNodePtr hitNode;
@@ -163,6 +182,39 @@ public:
 	float ambientMusicVolume;
 
     Scene();
+
+    // written by the nodes while the scene updates them
+    TransformStore* transformStore;
+
+    // set while updateSceneAnimation walks the tree
+    bool deferSkeletalAnimation;
+    QVector<SkeletalAnimationJob> skeletalAnimationJobs;
+
+private:
+    bool parallelUpdateEnabled;
+    bool transformStoreEnabled;
+
+    // mesh world bounds for picking, meshes without bounds are kept in a list
+    DynamicAABBTree* pickingTree;
+    QVector<MeshNode*> unboundedPickingNodes;
+
+    // scratch state of the parallel update, reused every frame
+    QVector<RenderList*> workerGeometryLists;
+    QVector<RenderList*> workerShadowLists;
+    QVector<MeshNode*> meshJobs;
+    QVector<ParticleJob> particleJobs;
+
+    void updateNodesParallel(float dt);
+    void updateParticleSystems(float dt);
+    void updateSkeletalAnimationsParallel();
+    void submitMeshesParallel();
+    void updatePickingTree();
+    void rayCastMesh(MeshNode* meshNode,
+                     const QVector3D& segStart,
+                     const QVector3D& segEnd,
+                     QList<iris::PickingResult>& hitList,
+                     uint64_t pickingMask,
+                     bool allowUnpickable);
 public:
     static ScenePtr create();
 
@@ -209,10 +261,45 @@ public:
 	void startPlayingAmbientMusic();
 	void setAmbientMusicVolume(float volume);
 
+    /*
+     * Samples every node's animation at time. With parallel updates enabled,
+     * skeletons that dont share nodes or meshes are evaluated on the thread pool
+     */
     void updateSceneAnimation(float time);
     void update(float dt);
     void render();
 
+    /*
+     * Large scenes have their hierarchy update and render item extraction
+     * spread across worker threads. The resulting transforms and render lists
+     * are identical to the single threaded path
+     */
+    void setParallelUpdateEnabled(bool enabled)
+    {
+        parallelUpdateEnabled = enabled;
+    }
+
+    bool isParallelUpdateEnabled()
+    {
+        return parallelUpdateEnabled;
+    }
+
+    /*
+     * Computes all world matrices in one pass over a flat copy of the
+     * hierarchy instead of walking the nodes, see TransformStore
+     */
+    void setTransformStoreEnabled(bool enabled);
+
+    bool isTransformStoreEnabled()
+    {
+        return transformStoreEnabled;
+    }
+
+    /*
+     * Appends every hit along the segment sorted by distance from segStart
+     * Meshes are found through a bounding volume tree that is kept up to date
+     * by update(), so nodes are only pickable once the scene has been updated
+     */
     void rayCast(const QVector3D& segStart,
                  const QVector3D& segEnd,
                  QList<PickingResult>& hitList,
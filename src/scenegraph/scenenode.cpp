@@ -14,6 +14,10 @@ For more information see the LICENSE file
 #include <functional>
 
 #include "animation/animation.h"
+#include "animation/bakedanimation.h"
+#include "animation/skeletonbinding.h"
+#include "animation/propertyanimbinding.h"
+#include "animation/animationmixer.h"
 #include "animation/animableproperty.h"
 #include "animation/keyframeanimation.h"
 #include "animation/keyframeset.h"
@@ -58,7 +62,10 @@ SceneNode::SceneNode():
     attached = false;
 
     transformDirty = true;
+    worldTransformDirty = true;
     hasDirtyChildren = true;
+    transformVersion = 0;
+    transformIndex = -1;
 
     //keyFrameSet = KeyFrameSet::create();
     //animation = iris::Animation::create("");
@@ -78,6 +85,8 @@ QString SceneNode::getName()
 void SceneNode::setName(QString name)
 {
     this->name = name;
+    // bones are matched to nodes by name
+    invalidateSkeletonBindings();
 }
 
 long SceneNode::getNodeId()
@@ -119,8 +128,23 @@ void SceneNode::setLocalTransform(QMatrix4x4 transformMatrix)
 }
 
 void SceneNode::setTransformDirty()
+{
+    setSubtreeTransformDirty();
+    propagateTransformDirty();
+}
+
+void SceneNode::setSubtreeTransformDirty()
 {
     transformDirty = true;
+    setWorldTransformDirty();
+}
+
+void SceneNode::propagateTransformDirty()
+{
+    if (!!scene && scene->transformStore && transformIndex >= 0)
+    {
+        scene->transformStore->markDirty(transformIndex);
+    }
     if (!!parent)
     {
         parent->setHasDirtyChildren();
@@ -129,6 +153,10 @@ void SceneNode::setTransformDirty()
 
 void SceneNode::setHasDirtyChildren()
 {
+    // a flagged node always has flagged ancestors so the walk can stop here
+    if (hasDirtyChildren)
+        return;
+
     hasDirtyChildren = true;
     if (!!parent)
     {
@@ -136,6 +164,19 @@ void SceneNode::setHasDirtyChildren()
     }
 }
 
+void SceneNode::setWorldTransformDirty()
+{
+    // descendants of a stale node are already stale
+    if (worldTransformDirty)
+        return;
+
+    worldTransformDirty = true;
+    hasDirtyChildren = true;
+    for (auto& child : children) {
+        child->setWorldTransformDirty();
+    }
+}
+
 bool SceneNode::isAttached()
 {
     return attached;
@@ -159,6 +200,48 @@ QList<AnimationPtr> SceneNode::getAnimations()
 void SceneNode::setAnimation(AnimationPtr anim)
 {
     animation = anim;
+    propertyAnimBinding.reset();
+    // ancestors' bindings track whether they contain animated nodes
+    invalidateSkeletonBindings();
+}
+
+SkeletonBindingPtr SceneNode::getSkeletonBinding()
+{
+    if (!skeletonBinding || !skeletonBinding->isBoundTo(animation))
+        skeletonBinding = SkeletonBinding::create(this, animation);
+
+    return skeletonBinding;
+}
+
+void SceneNode::invalidateSkeletonBindings()
+{
+    // any animated ancestor may have this node in its binding
+    for (auto node = this; node != nullptr; node = node->parent.data())
+        node->skeletonBinding.reset();
+}
+
+PropertyAnimBindingPtr SceneNode::getPropertyAnimBinding()
+{
+    if (!propertyAnimBinding || !propertyAnimBinding->isBoundTo(animation))
+        propertyAnimBinding = PropertyAnimBinding::create(this, animation);
+
+    return propertyAnimBinding;
+}
+
+void SceneNode::bindPropertyAnims(PropertyAnimBinding* binding)
+{
+    binding->bind("position", [](SceneNode* node, PropertyAnim* anim, float time) {
+        node->setLocalPos(static_cast<Vector3DPropertyAnim*>(anim)->getValue(time));
+    });
+
+    binding->bind("rotation", [](SceneNode* node, PropertyAnim* anim, float time) {
+        auto r = static_cast<Vector3DPropertyAnim*>(anim)->getValue(time);
+        node->setLocalRot(QQuaternion::fromEulerAngles(r));
+    });
+
+    binding->bind("scale", [](SceneNode* node, PropertyAnim* anim, float time) {
+        node->setLocalScale(static_cast<Vector3DPropertyAnim*>(anim)->getValue(time));
+    });
 }
 
 AnimationPtr SceneNode::getAnimation()
@@ -166,6 +249,17 @@ AnimationPtr SceneNode::getAnimation()
     return animation;
 }
 
+void SceneNode::setAnimationMixer(AnimationMixerPtr mixer)
+{
+    animationMixer = mixer;
+    invalidateSkeletonBindings();
+}
+
+AnimationMixerPtr SceneNode::getAnimationMixer()
+{
+    return animationMixer;
+}
+
 bool SceneNode::hasActiveAnimation()
 {
     return !!animation;
@@ -238,6 +332,7 @@ void SceneNode::insertChild(int position, SceneNodePtr node, bool keepTransform)
 
     children.insert(position, node);
     node->setParent(self);
+    invalidateSkeletonBindings();
     if (!!scene) {
         node->setScene(self->scene);
         //scene->addNode(node);
@@ -263,6 +358,9 @@ void SceneNode::insertChild(int position, SceneNodePtr node, bool keepTransform)
         node->scale.setY(diff.column(1).toVector3D().length());
         node->scale.setZ(diff.column(2).toVector3D().length());
     }
+
+    // the node has a new parent so its world transform changes either way
+    node->setTransformDirty();
 }
 
 void SceneNode::removeFromParent()
@@ -275,7 +373,11 @@ void SceneNode::removeFromParent()
 void SceneNode::removeChild(SceneNodePtr node)
 {
     children.removeOne(node);
+    invalidateSkeletonBindings();
+    // subtree bounds need to be merged again without the node
+    setHasDirtyChildren();
     node->parent = QSharedPointer<SceneNode>(Q_NULLPTR);
+    node->setTransformDirty();
     node->removeFromScene();
 }
 
@@ -287,6 +389,9 @@ bool SceneNode::isRootNode()
 
 void SceneNode::updateAnimation(float time)
 {
+    // the mixer keeps its own time for each layer
+    float rawTime = time;
+
     if (!!animation) {
 
         if (animation->getLength() > 60.0f) {
@@ -294,56 +399,29 @@ void SceneNode::updateAnimation(float time)
         }
 
         time = animation->getSampleTime(time);
-        if (animation->hasPropertyAnim("position")) {
-            pos = animation->getVector3PropertyAnim("position")->getValue(time);
-        }
-        if (animation->hasPropertyAnim("rotation")) {
-            auto r = animation->getVector3PropertyAnim("rotation")->getValue(time);
-            rot = QQuaternion::fromEulerAngles(r);
-        }
-        if (animation->hasPropertyAnim("scale")) {
-            scale = animation->getVector3PropertyAnim("scale")->getValue(time);
-        }
+        getPropertyAnimBinding()->apply(this, time, rawTime);
 
         if (animation->hasSkeletalAnimation()) {
-            QMap<QString, QMatrix4x4> skeletonSpaceMatrices;
-            // The skeleton begins at this node, the root
-
-            // recursively update the animation for each node
-            std::function<void(SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)> animateHierarchy;
-            animateHierarchy = [&animateHierarchy, time, &skeletonSpaceMatrices](SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)
-            {
-                // skeleton-space transform of current node
-                QMatrix4x4 skelTrans;
-                skelTrans.setToIdentity();
-
-                if (anim->boneAnimations.contains(node->name)) {
-                    auto boneAnim = anim->boneAnimations[node->name];
-
-                    node->pos = boneAnim->posKeys->getValueAt(time);
-                    node->rot = boneAnim->rotKeys->getValueAt(time).normalized();
-                    //node->scale = QVector3D(1,1,1);
-                    node->scale = boneAnim->scaleKeys->getValueAt(time);
-                }
-
-                auto localTrans = node->getLocalTransform(); //calculates the local transform matrix
-                skelTrans = parentTransform * localTrans; //skeleton space transform
-                skeletonSpaceMatrices.insert(node->name, skelTrans);
-
-                for(auto child : node->children) {
-                    animateHierarchy(anim, child, skelTrans);
-                }
-            };
-
-            QMatrix4x4 rootTransform;
-            //rootTransform.setToIdentity();
-            rootTransform = this->getLocalTransform();
-            animateHierarchy(animation->getSkeletalAnimation(), this->sharedFromThis(), rootTransform);
-
-            applyAnimationPose(this->sharedFromThis(), skeletonSpaceMatrices);
+            auto binding = getSkeletonBinding();
+
+            // skeletons that dont overlap other animations are evaluated
+            // by the scene on the thread pool once the whole tree is visited
+            if (!!scene && scene->deferSkeletalAnimation && !binding->hasNestedAnimations && !animationMixer)
+                scene->skeletalAnimationJobs.append({binding, AnimationMixerPtr(), time});
+            else
+                binding->applyAnimation(time);
         }
     }
 
+    if (!!animationMixer) {
+        auto binding = getSkeletonBinding();
+
+        if (!!scene && scene->deferSkeletalAnimation && !binding->hasNestedAnimations)
+            scene->skeletalAnimationJobs.append({binding, animationMixer, rawTime});
+        else
+            animationMixer->apply(binding, rawTime);
+    }
+
     for (auto child : children) {
         child->updateAnimation(time);
     }
@@ -353,32 +431,7 @@ void SceneNode::applyDefaultPose()
 {
     if (!!animation) {
     if (animation->hasSkeletalAnimation()) {
-        QMap<QString, QMatrix4x4> skeletonSpaceMatrices;
-        // The skeleton begins at this node, the root
-
-        // recursively update the animation for each node
-        std::function<void(SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)> animateHierarchy;
-        animateHierarchy = [&animateHierarchy, &skeletonSpaceMatrices](SkeletalAnimationPtr anim, SceneNodePtr node, QMatrix4x4 parentTransform)
-        {
-            // skeleton-space transform of current node
-            QMatrix4x4 skelTrans;
-            skelTrans.setToIdentity();
-
-            auto localTrans = node->getLocalTransform(); //calculates the local transform matrix
-            skelTrans = parentTransform * localTrans; //skeleton space transform
-            skeletonSpaceMatrices.insert(node->name, skelTrans);
-
-            for(auto child : node->children) {
-                animateHierarchy(anim, child, skelTrans);
-            }
-        };
-
-        QMatrix4x4 rootTransform;
-        rootTransform.setToIdentity();
-        rootTransform = this->getLocalTransform();
-        animateHierarchy(animation->getSkeletalAnimation(), this->sharedFromThis(), rootTransform);
-
-        applyAnimationPose(this->sharedFromThis(), skeletonSpaceMatrices);
+        getSkeletonBinding()->applyCurrentPose();
     }
     }
 
@@ -387,7 +440,7 @@ void SceneNode::applyDefaultPose()
     }
 }
 
-void SceneNode::applyAnimationPose(SceneNodePtr node, QMap<QString, QMatrix4x4> skeletonSpaceMatrices)
+void SceneNode::applyAnimationPose(SceneNodePtr node, const QMap<QString, QMatrix4x4>& skeletonSpaceMatrices)
 {
     if (skeletonSpaceMatrices.contains(node->name)) {
         if (node->sceneNodeType == SceneNodeType::Mesh) {
@@ -406,6 +459,35 @@ void SceneNode::applyAnimationPose(SceneNodePtr node, QMap<QString, QMatrix4x4>
 }
 
 void SceneNode::update(float dt)
+{
+    // nothing in this subtree changed since the last update, the cached
+    // transforms and bounds are still valid
+    if (!hasDirtyChildren)
+        return;
+
+    // cleared before visiting the children so nodes that need updating
+    // every frame can flag themselves again
+    hasDirtyChildren = false;
+
+    updateTransform();
+
+    for (auto& child : children) {
+        child->update(dt);
+    }
+
+    updateSubtreeBounds();
+}
+
+bool SceneNode::updateTransform()
+{
+    if (!worldTransformDirty)
+        return false;
+
+    getGlobalTransform();
+    return true;
+}
+
+void SceneNode::updateLocalTransform()
 {
     if (transformDirty) {
         localTransform.setToIdentity();
@@ -414,20 +496,24 @@ void SceneNode::update(float dt)
         localTransform.rotate(rot);
         localTransform.scale(scale);
 
-        if (!!parent) {
-            globalTransform = this->parent->globalTransform * localTransform;
-        } else {
-            globalTransform = localTransform;
-        }
+        transformDirty = false;
     }
+}
 
-    if (hasDirtyChildren) {
-        for (auto child : children) {
-            child->update(dt);
-        }
+void SceneNode::updateSubtreeBounds()
+{
+    updateWorldBounds();
+    subtreeBounds = worldBounds;
+    for (auto& child : children) {
+        subtreeBounds.merge(child->subtreeBounds);
     }
 }
 
+void SceneNode::updateWorldBounds()
+{
+    worldBounds.setNegativeInfinity();
+}
+
 void SceneNode::setParent(SceneNodePtr node)
 {
     this->parent = node;
@@ -477,19 +563,22 @@ QVector3D SceneNode::getGlobalPosition()
     return getGlobalTransform().column(3).toVector3D();
 }
 
+// Only stale nodes are recalculated, so this is a copy of the cached matrix
+// unless the node or one of its ancestors moved since it was last computed
 QMatrix4x4 SceneNode::getGlobalTransform()
 {
-    localTransform.setToIdentity();
+    if (worldTransformDirty) {
+        updateLocalTransform();
 
-    localTransform.translate(pos);
-    localTransform.rotate(rot);
-    localTransform.scale(scale);
+        if (parent.isNull()) {
+            // this is a check for the root node
+            globalTransform = localTransform;
+        } else {
+            globalTransform = parent->getGlobalTransform() * localTransform;
+        }
 
-    if (parent.isNull()) {
-        // this is a check for the root node
-        globalTransform = localTransform;
-    } else {
-        globalTransform = parent->getGlobalTransform() * localTransform;
+        worldTransformDirty = false;
+        transformVersion++;
     }
 
     return globalTransform;
@@ -497,12 +586,7 @@ QMatrix4x4 SceneNode::getGlobalTransform()
 
 QMatrix4x4 SceneNode::getLocalTransform()
 {
-    localTransform.setToIdentity();
-
-    localTransform.translate(pos);
-    localTransform.rotate(rot);
-    localTransform.scale(scale);
-
+    updateLocalTransform();
     return localTransform;
 }
 
@@ -510,6 +594,7 @@ void SceneNode::setGlobalPos(QVector3D pos)
 {
 	if (!parent) {
 		this->pos = pos;
+		this->setTransformDirty();
 		return;
 	}
 
@@ -525,6 +610,7 @@ void SceneNode::setGlobalRot(QQuaternion rot)
 {
 	if (!parent) {
 		this->rot = rot;
+		this->setTransformDirty();
 		return;
 	}
 
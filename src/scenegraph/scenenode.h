@@ -18,6 +18,7 @@ For more information see the LICENSE file
 #include <QVector3D>
 
 #include "irisglfwd.h"
+#include "geometry/aabb.h"
 #include "physics/physicsproperties.h"
 
 namespace iris
@@ -44,18 +45,41 @@ class SceneNode : public QEnableSharedFromThis<SceneNode>
 protected:
     QList<AnimationPtr> animations;
     AnimationPtr animation;
+    AnimationMixerPtr animationMixer;
 
+    /*
+     * Prefer setLocalPos, setLocalRot and setLocalScale. Code that writes these
+     * directly MUST call setTransformDirty() afterwards, otherwise update()
+     * skips the node as clean and the TransformStore never sees the change
+     */
     QVector3D pos;
     QVector3D scale;
     QQuaternion rot;
 
+    // pos, rot or scale changed so localTransform needs rebuilding
     bool transformDirty;
+    // globalTransform is stale, set on the node and all of its descendants
+    bool worldTransformDirty;
+    // this node or something below it needs to be visited by update()
     bool hasDirtyChildren;
+    // bumped every time globalTransform is recalculated
+    unsigned int transformVersion;
+    // slot in the scene's TransformStore, -1 if not assigned
+    int transformIndex;
+    // resolved lazily for skeletal animations, see getSkeletonBinding()
+    SkeletonBindingPtr skeletonBinding;
+    // resolved lazily for property animations, see getPropertyAnimBinding()
+    PropertyAnimBindingPtr propertyAnimBinding;
 public:
     // cached local and global transform
     QMatrix4x4 localTransform;
     QMatrix4x4 globalTransform;
 
+    // world-space bounds of this node's own geometry and of its whole subtree
+    // both are recalculated in update() and are null if there's nothing to bound
+    AABB worldBounds;
+    AABB subtreeBounds;
+
     SceneNodeType sceneNodeType;
 
     QString name;
@@ -92,6 +116,9 @@ public:
 
     friend class Renderer;
     friend class Scene;
+    friend class TransformStore;
+    friend class SkeletonBinding;
+    friend class PropertyAnimBinding;
 
     // If a node is attached to parents then it inherits animations
     // It also cant have its own animation
@@ -152,9 +179,23 @@ public:
 
     void setLocalTransform(QMatrix4x4 transformMatrix);
 
+    /*
+     * Marks the local transform as changed. The world transforms of this node
+     * and its descendants are invalidated and its ancestors are flagged so the
+     * next update() only walks down to the changed subtrees
+     */
     void setTransformDirty();
     void setHasDirtyChildren();
 
+    /*
+     * Changes every time the global transform is recalculated, callers caching
+     * data derived from it can compare versions instead of matrices
+     */
+    unsigned int getTransformVersion()
+    {
+        return transformVersion;
+    }
+
     bool isAttached();
     void setAttached(bool attached);
 
@@ -168,6 +209,13 @@ public:
     void setAnimation(AnimationPtr anim);
     AnimationPtr getAnimation();
     bool hasActiveAnimation();
+
+    /*
+     * Blends skeletal animations onto this node's hierarchy, applied after
+     * the node's own animation. A mixer should only be set on one node
+     */
+    void setAnimationMixer(AnimationMixerPtr mixer);
+    AnimationMixerPtr getAnimationMixer();
     void deleteAnimation(int index);
     void deleteAnimation(AnimationPtr anim);
 
@@ -259,8 +307,32 @@ public:
      */
     virtual void update(float dt);
     virtual void updateAnimation(float time);
+
+    /*
+     * The two halves of update() for this node alone, excluding children
+     * Used by the scene to spread the hierarchy update over multiple threads
+     * updateTransform returns false if the global transform was already up to date
+     */
+    bool updateTransform();
+    void updateSubtreeBounds();
+
+    /*
+     * Recalculates worldBounds from the global transform.
+     * Nodes without geometry leave it null
+     */
+    virtual void updateWorldBounds();
+
     void applyDefaultPose();
-    void applyAnimationPose(SceneNodePtr node, QMap<QString, QMatrix4x4> skeletonSpaceMatrices);
+    void applyAnimationPose(SceneNodePtr node, const QMap<QString, QMatrix4x4>& skeletonSpaceMatrices);
+
+    // the current animation bound to this node's hierarchy, rebuilt if stale
+    SkeletonBindingPtr getSkeletonBinding();
+
+    // drops the bindings of this node and its ancestors after the hierarchy changes
+    void invalidateSkeletonBindings();
+
+    // the current animation's property tracks bound to this node, rebuilt if stale
+    PropertyAnimBindingPtr getPropertyAnimBinding();
 
     /*
      * This is the function used to add render items
@@ -269,7 +341,22 @@ public:
      */
     virtual void submitRenderItems(){}
 
+protected:
+    /*
+     * Adds a track to the binding for each property this node can animate
+     * Subclasses with animatable properties of their own add theirs after the base ones
+     */
+    virtual void bindPropertyAnims(PropertyAnimBinding* binding);
+
 private:
+    // the two halves of setTransformDirty, the first only touches this node
+    // and its descendants so it can run on a job that owns the subtree
+    void setSubtreeTransformDirty();
+    void propagateTransformDirty();
+
+    void setWorldTransformDirty();
+    void updateLocalTransform();
+
     void setParent(SceneNodePtr node);
     void setScene(ScenePtr scene);
     void removeFromScene();
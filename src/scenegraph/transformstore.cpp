@@ -0,0 +1,202 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#include "transformstore.h"
+#include "scenenode.h"
+
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORMSTORE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace iris
+{
+
+// result = a * b, all column-major
+static inline void multiplyMatrices(const TransformMatrix& a, const TransformMatrix& b, TransformMatrix& result)
+{
+#ifdef TRANSFORMSTORE_SSE
+    __m128 a0 = _mm_load_ps(a.m);
+    __m128 a1 = _mm_load_ps(a.m + 4);
+    __m128 a2 = _mm_load_ps(a.m + 8);
+    __m128 a3 = _mm_load_ps(a.m + 12);
+
+    for (int col = 0; col < 4; col++) {
+        const float* b_col = b.m + col * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b_col[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b_col[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b_col[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b_col[3])));
+        _mm_store_ps(result.m + col * 4, r);
+    }
+#else
+    for (int col = 0; col < 4; col++) {
+        const float* b_col = b.m + col * 4;
+        for (int row = 0; row < 4; row++) {
+            result.m[col * 4 + row] = a.m[row] * b_col[0] +
+                                      a.m[4 + row] * b_col[1] +
+                                      a.m[8 + row] * b_col[2] +
+                                      a.m[12 + row] * b_col[3];
+        }
+    }
+#endif
+}
+
+TransformStore::TransformStore()
+{
+    needsRebuild = true;
+}
+
+void TransformStore::invalidate()
+{
+    needsRebuild = true;
+}
+
+void TransformStore::markDirty(int index)
+{
+    // indices are reassigned on rebuild and every node starts dirty then
+    if (needsRebuild || index >= dirty.size() || dirty[index])
+        return;
+
+    dirty[index] = 1;
+    dirtyIndices.append(index);
+}
+
+void TransformStore::rebuild(const SceneNodePtr& rootNode)
+{
+    nodes.clear();
+    parents.clear();
+
+    // depth first so subtrees stay contiguous and parents precede children
+    QVector<QPair<SceneNode*, int>> stack;
+    stack.append(qMakePair(rootNode.data(), -1));
+    while (!stack.isEmpty()) {
+        auto entry = stack.takeLast();
+        auto node = entry.first;
+
+        node->transformIndex = nodes.size();
+        nodes.append(node);
+        parents.append(entry.second);
+
+        for (int i = node->children.size() - 1; i >= 0; i--)
+            stack.append(qMakePair(node->children[i].data(), node->transformIndex));
+    }
+
+    const int count = nodes.size();
+    positions.resize(count);
+    rotations.resize(count);
+    scales.resize(count);
+    localMatrices.resize(count);
+    worldMatrices.resize(count);
+
+    dirty.fill(1, count);
+    changed.fill(0, count);
+    dirtyIndices.resize(count);
+    for (int i = 0; i < count; i++)
+        dirtyIndices[i] = i;
+
+    needsRebuild = false;
+}
+
+// same result as QMatrix4x4's translate(pos), rotate(rot), scale(scale)
+void TransformStore::composeLocalMatrix(int index)
+{
+    const QVector3D& p = positions[index];
+    const QQuaternion& q = rotations[index];
+    const QVector3D& s = scales[index];
+
+    float xx = q.x() * q.x();
+    float xy = q.x() * q.y();
+    float xz = q.x() * q.z();
+    float xw = q.x() * q.scalar();
+    float yy = q.y() * q.y();
+    float yz = q.y() * q.z();
+    float yw = q.y() * q.scalar();
+    float zz = q.z() * q.z();
+    float zw = q.z() * q.scalar();
+
+    float* m = localMatrices[index].m;
+    m[0] = (1.0f - 2.0f * (yy + zz)) * s.x();
+    m[1] = (2.0f * (xy + zw)) * s.x();
+    m[2] = (2.0f * (xz - yw)) * s.x();
+    m[3] = 0.0f;
+
+    m[4] = (2.0f * (xy - zw)) * s.y();
+    m[5] = (1.0f - 2.0f * (xx + zz)) * s.y();
+    m[6] = (2.0f * (yz + xw)) * s.y();
+    m[7] = 0.0f;
+
+    m[8] = (2.0f * (xz + yw)) * s.z();
+    m[9] = (2.0f * (yz - xw)) * s.z();
+    m[10] = (1.0f - 2.0f * (xx + yy)) * s.z();
+    m[11] = 0.0f;
+
+    m[12] = p.x();
+    m[13] = p.y();
+    m[14] = p.z();
+    m[15] = 1.0f;
+}
+
+void TransformStore::update(const SceneNodePtr& rootNode)
+{
+    if (needsRebuild)
+        rebuild(rootNode);
+
+    if (dirtyIndices.isEmpty())
+        return;
+
+    // gather the local transforms of the nodes that changed
+    for (int index : dirtyIndices) {
+        auto node = nodes[index];
+        positions[index] = node->pos;
+        rotations[index] = node->rot;
+        scales[index] = node->scale;
+    }
+    dirtyIndices.clear();
+
+    // a parent's world matrix is final by the time its children are reached
+    const int count = nodes.size();
+    for (int i = 0; i < count; i++) {
+        int parent = parents[i];
+        changed[i] = dirty[i] | (parent >= 0 ? changed[parent] : 0);
+
+        if (dirty[i]) {
+            composeLocalMatrix(i);
+            dirty[i] = 0;
+        }
+
+        if (changed[i]) {
+            if (parent >= 0)
+                multiplyMatrices(worldMatrices[parent], localMatrices[i], worldMatrices[i]);
+            else
+                worldMatrices[i] = localMatrices[i];
+        }
+    }
+
+    // write the results back so the rest of the engine sees up to date matrices
+    for (int i = 0; i < count; i++) {
+        if (!changed[i])
+            continue;
+
+        auto node = nodes[i];
+        memcpy(node->localTransform.data(), localMatrices[i].m, sizeof(float) * 16);
+        memcpy(node->globalTransform.data(), worldMatrices[i].m, sizeof(float) * 16);
+        node->transformDirty = false;
+        node->worldTransformDirty = false;
+        node->transformVersion++;
+
+        changed[i] = 0;
+    }
+}
+
+}
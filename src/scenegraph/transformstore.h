@@ -0,0 +1,87 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+#ifndef TRANSFORMSTORE_H
+#define TRANSFORMSTORE_H
+
+#include <QVector>
+#include <QVector3D>
+#include <QQuaternion>
+#include <vector>
+
+#include "../irisglfwd.h"
+
+namespace iris
+{
+
+class SceneNode;
+
+// column-major like QMatrix4x4 but without the flag word, aligned for sse loads
+struct alignas(16) TransformMatrix
+{
+    float m[16];
+};
+
+/*
+ * Structure-of-arrays copy of a scene's transform hierarchy.
+ * Nodes are laid out in depth first order so parents always come before their
+ * children and every world matrix can be computed in a single pass over the arrays.
+ * A node's index into the store is assigned on rebuild. Changed nodes push their
+ * local transforms in and the results are written back to the nodes' cached matrices.
+ */
+class TransformStore
+{
+public:
+    TransformStore();
+
+    // the hierarchy changed, the arrays are rebuilt on the next update
+    void invalidate();
+
+    // called by SceneNode::setTransformDirty
+    void markDirty(int index);
+
+    void update(const SceneNodePtr& rootNode);
+
+    int size() const
+    {
+        return nodes.size();
+    }
+
+    const TransformMatrix& getWorldMatrix(int index) const
+    {
+        return worldMatrices[index];
+    }
+
+private:
+    void rebuild(const SceneNodePtr& rootNode);
+    void composeLocalMatrix(int index);
+
+    bool needsRebuild;
+
+    QVector<SceneNode*> nodes;
+    QVector<int> parents;
+
+    QVector<QVector3D> positions;
+    QVector<QQuaternion> rotations;
+    QVector<QVector3D> scales;
+
+    // dirty is set when the local transform changed, changed when the world matrix did
+    QVector<quint8> dirty;
+    QVector<quint8> changed;
+    QVector<int> dirtyIndices;
+
+    std::vector<TransformMatrix> localMatrices;
+    std::vector<TransformMatrix> worldMatrices;
+};
+
+}
+
+#endif // TRANSFORMSTORE_H
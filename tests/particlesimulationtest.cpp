@@ -0,0 +1,178 @@
+/**************************************************************************
+This file is part of IrisGL
+http://www.irisgl.org
+Copyright (c) 2016  GPLv3 Jahshaka LLC <coders@jahshaka.com>
+
+This is free software: you may copy, redistribute
+and/or modify it under the terms of the GPLv3 License
+
+For more information see the LICENSE file
+*************************************************************************/
+
+// Runs a particle system on the cpu and with the gpu simulator from the same
+// seed and checks that both end up with the same particles
+// The pool is kept from filling up, the two modes only differ once it's full
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLVersionFunctionsFactory>
+#include <QSurfaceFormat>
+#include <QtMath>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include "graphics/graphicsdevice.h"
+#include "graphics/gpuparticlesimulator.h"
+#include "scenegraph/particlesystemnode.h"
+
+using namespace iris;
+
+#define TEST_STEPS 240
+#define TEST_SEED 1234567
+// position error, relative to the value or absolute below 1
+#define TEST_TOLERANCE 1e-3f
+// ctest treats it as skipped
+#define TEST_SKIPPED 77
+
+// a_particle, a_particleParams and a_particleVelocity
+#define GPU_PARTICLE_FLOATS 12
+
+// elapsed time, position
+typedef std::array<float, 4> Particle;
+
+static ParticleSystemNodePtr createSystem(bool gpu)
+{
+    auto system = ParticleSystemNode::create();
+    system->setGpuSimulation(gpu);
+    system->setRandomSeed(TEST_SEED);
+    system->maxParticles = 2000;
+    system->setPPS(250.5f);
+    system->setSpeed(6);
+    system->setSpeedError(0.3f);
+    system->setLife(1.2f);
+    system->setLifeError(0.3f);
+    system->setParticleScale(1);
+    system->setScaleError(0.3f);
+    system->setGravity(0.2f);
+    system->setDissipation(true);
+    system->setRandomRotation(true);
+    return system;
+}
+
+// moves and turns the emitter so every step emits from a new transform
+static void step(const ParticleSystemNodePtr& system, int index, float delta)
+{
+    system->setLocalPos(QVector3D(qSin(index * 0.05f) * 3, index * 0.01f, 0));
+    system->setLocalRot(QQuaternion::fromEulerAngles(index * 0.5f, 0, 0));
+    system->update(delta);
+    system->simulate(delta);
+}
+
+int main(int argc, char** argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+
+    QSurfaceFormat format;
+    format.setVersion(3, 2);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        printf("skipped, no gl 3.2 context\n");
+        return TEST_SKIPPED;
+    }
+
+    auto device = GraphicsDevice::create();
+    if (!device->supportsInstancing()) {
+        printf("skipped, the gpu simulator needs instancing\n");
+        return TEST_SKIPPED;
+    }
+
+    auto cpuSystem = createSystem(false);
+    auto gpuSystem = createSystem(true);
+
+    for (int i = 0; i < TEST_STEPS; i++) {
+        // uneven steps so the partial particles are exercised
+        float delta = 0.016f + 0.004f * (i % 3);
+        step(cpuSystem, i, delta);
+        step(gpuSystem, i, delta);
+
+        // what renderParticles does, without drawing
+        gpuSystem->gpuSimulator->setCapacity(gpuSystem->maxParticles);
+        for (auto& gpuStep : gpuSystem->gpuSteps)
+            gpuSystem->gpuSimulator->simulate(device, gpuStep);
+        gpuSystem->gpuSteps.clear();
+    }
+
+    auto gl = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_3_2_Core>(&context);
+    auto buffer = gpuSystem->gpuSimulator->getParticleBuffer();
+    int capacity = gpuSystem->gpuSimulator->getCapacity();
+    QVector<float> slots(capacity * GPU_PARTICLE_FLOATS);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, buffer->bufferId);
+    gl->glGetBufferSubData(GL_ARRAY_BUFFER, 0, slots.size() * sizeof(float), slots.data());
+    gl->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // free slots have no life left
+    QVector<Particle> gpuParticles;
+    for (int i = 0; i < capacity; i++) {
+        const float* slot = slots.constData() + i * GPU_PARTICLE_FLOATS;
+        float elapsed = slot[6];
+        float life = slot[7];
+        if (life > 0 && elapsed <= life)
+            gpuParticles.append({elapsed, slot[0], slot[1], slot[2]});
+    }
+
+    const auto& pool = cpuSystem->particles;
+    QVector<Particle> cpuParticles;
+    for (int i = 0; i < pool.count; i++)
+        cpuParticles.append({pool.elapsedTime[i], pool.positionX[i], pool.positionY[i], pool.positionZ[i]});
+
+    // particles emitted in one step share their elapsed time, the order within a step doesnt matter
+    std::sort(gpuParticles.begin(), gpuParticles.end());
+    std::sort(cpuParticles.begin(), cpuParticles.end());
+
+    printf("cpu particles: %d, gpu particles: %d\n", int(cpuParticles.size()), int(gpuParticles.size()));
+    if (pool.isFull()) {
+        printf("FAIL: the pool filled up, raise maxParticles\n");
+        return 1;
+    }
+
+    if (cpuParticles.isEmpty() || cpuParticles.size() != gpuParticles.size()) {
+        printf("FAIL: the particle counts differ\n");
+        return 1;
+    }
+
+    float maxError = 0;
+    int mismatches = 0;
+    for (int i = 0; i < cpuParticles.size(); i++) {
+        float error = 0;
+        for (int c = 1; c < 4; c++) {
+            float expected = cpuParticles[i][c];
+            error = qMax(error, qAbs(gpuParticles[i][c] - expected) / qMax(1.0f, qAbs(expected)));
+        }
+
+        maxError = qMax(maxError, error);
+        if (error > TEST_TOLERANCE)
+            mismatches++;
+    }
+
+    printf("largest position error: %g\n", maxError);
+    if (mismatches > 0) {
+        printf("FAIL: %d particles are further apart than %g\n", mismatches, TEST_TOLERANCE);
+        return 1;
+    }
+
+    printf("PASS\n");
+    return 0;
+}